@@ -40,8 +40,10 @@ namespace art {
   {
     if (duplicateCheckMode_ == noDuplicateCheck)
       return;
-    if (duplicateCheckMode_ == checkAllFilesOpened)
+    if (duplicateCheckMode_ == checkAllFilesOpened) {
+      eventIDs_.reserve(fileIndex);
       return;
+    }
 
     assert(dataType_ == unknown);
     dataType_ = realData ? isRealData : isSimulation;
@@ -50,6 +52,9 @@ namespace art {
         (duplicateCheckMode_ == checkEachRealDataFile &&
          dataType_ == isRealData)) {
       itIsKnownTheFileHasNoDuplicates_ = fileIndex.eventsUniqueAndOrdered();
+      if (!itIsKnownTheFileHasNoDuplicates_) {
+        eventIDs_.reserve(fileIndex);
+      }
     }
   }
 
@@ -83,7 +88,7 @@ namespace art {
         return false;
     }
 
-    bool duplicate = !eventIDs_.insert(eventID).second;
+    bool duplicate = !eventIDs_.insert(eventID);
 
     if (duplicate) {
       if (duplicateCheckMode_ == checkAllFilesOpened) {
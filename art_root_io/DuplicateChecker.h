@@ -13,10 +13,10 @@
 //
 // ======================================================================
 
+#include "art_root_io/detail/EventIDSet.h"
 #include "canvas/Persistency/Provenance/EventID.h"
 #include "fhiclcpp/types/Atom.h"
 #include "fhiclcpp/types/TableFragment.h"
-#include <set>
 #include <string>
 
 // ----------------------------------------------------------------------
@@ -56,7 +56,8 @@ namespace art {
 
     DataType dataType_;
 
-    std::set<EventID> eventIDs_;
+    // Sized from the FileIndex of each file as it is opened.
+    detail::EventIDSet eventIDs_;
 
     bool itIsKnownTheFileHasNoDuplicates_;
   }; // DuplicateChecker
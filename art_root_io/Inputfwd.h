@@ -2,19 +2,24 @@
 #define art_root_io_Inputfwd_h
 // vim: set sw=2 expandtab :
 
+#include "canvas/Persistency/Provenance/ProductID.h"
+
 #include "Rtypes.h"
 
-#include <map>
+#include <chrono>
+#include <cstddef>
+#include <utility>
 #include <vector>
 
 class TBranch;
+class TClass;
 class TTree;
 
 namespace art {
 
   class BranchDescription;
+  class EDProduct;
   struct FileFormatVersion;
-  class ProductID;
   class RootInputFile;
   class RootDelayedReader;
   class RootInputTree;
@@ -25,20 +30,85 @@ namespace art {
   namespace input {
 
     struct BranchInfo {
-      BranchInfo(BranchDescription const& prod, TBranch* const branch)
-        : branchDescription_{prod}, productBranch_{branch}
-      {}
+      // The dictionary of the wrapped product type is looked up here,
+      // once, if the branch is present.
+      BranchInfo(BranchDescription const& prod, TBranch* branch);
+
+      // Default-construct a product of the wrapped type, without a
+      // dictionary lookup.
+      EDProduct* newProduct() const;
+
+      // Activate or deactivate the branch, including its sub-branches,
+      // and its entry in the TTreeCache.  A deactivated branch is
+      // neither read nor cached.  Called with the input-source lock
+      // held.
+      void setActive(bool active) const;
 
       // Ideally, a reference to the branch-description does not need
       // to be retained.  It is used to fill the groups in the
       // principal.
       BranchDescription const& branchDescription_;
       TBranch* productBranch_;
+      TClass* wrappedClass_{nullptr};
+      ROOT::NewFunc_t newWrapped_{nullptr};
+
+      // Statistics of the reads from productBranch_, updated with the
+      // input-source lock held.  A read is a cache hit if it was satisfied
+      // without reading from the file.  The times are measured only if
+      // the statistics are reported.
+      struct ReadStats {
+        unsigned long reads{};
+        unsigned long cacheHits{};
+        unsigned long long bytes{};
+        std::chrono::nanoseconds stallTime{};
+        // Time spent waiting for the input-source lock, measured only for the
+        // RootIOStatistics service.
+        std::chrono::nanoseconds lockWait{};
+      };
+      mutable ReadStats readStats_{};
+      mutable bool active_{true};
+    };
+
+    // The product branches of a tree, stored contiguously in the order
+    // in which they were added, with a sorted index of their product
+    // IDs.  It is filled when the file is opened; lookups for delayed
+    // reads then search a dense array of IDs instead of walking a
+    // node-based map.
+    class BranchMap {
+    public:
+      using value_type = std::pair<ProductID, BranchInfo>;
+      using const_iterator = std::vector<value_type>::const_iterator;
+
+      // Does nothing if a branch for the product is already present.
+      void emplace(ProductID pid, BranchInfo&& info);
+
+      const_iterator find(ProductID pid) const;
+      const_iterator
+      begin() const
+      {
+        return branches_.cbegin();
+      }
+      const_iterator
+      end() const
+      {
+        return branches_.cend();
+      }
+      std::size_t
+      size() const
+      {
+        return branches_.size();
+      }
+
+    private:
+      std::vector<value_type> branches_{};
+      // Product IDs, sorted, and the positions of their branches.
+      std::vector<ProductID> ids_{};
+      std::vector<std::size_t> positions_{};
     };
 
-    using BranchMap = std::map<ProductID, BranchInfo>;
     using EntryNumber = Long64_t;
     using EntryNumbers = std::vector<EntryNumber>;
+
     Int_t getEntry(TBranch* branch, EntryNumber entryNumber);
     Int_t getEntry(TTree* tree, EntryNumber entryNumber);
 
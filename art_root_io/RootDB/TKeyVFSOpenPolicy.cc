@@ -3,8 +3,10 @@
 #include "canvas/Utilities/Exception.h"
 #include "cetlib/sqlite/helpers.h"
 
-art::TKeyVFSOpenPolicy::TKeyVFSOpenPolicy(TFile* const tfile, int const flags)
-  : tfile_{tfile}, flags_{flags | SQLITE_OPEN_URI}
+art::TKeyVFSOpenPolicy::TKeyVFSOpenPolicy(TFile* const tfile,
+                                          int const flags,
+                                          int const pageSize)
+  : tfile_{tfile}, flags_{flags | SQLITE_OPEN_URI}, pageSize_{pageSize}
 {}
 
 sqlite3*
@@ -17,7 +19,8 @@ art::TKeyVFSOpenPolicy::open(std::string const& key)
 
   auto const uriKey = cet::sqlite::assembleNoLockURI(key);
   sqlite3* db{nullptr};
-  int const rc{tkeyvfs_open_v2(uriKey.c_str(), &db, flags_, tfile_)};
+  int const rc{
+    tkeyvfs_open_v2(uriKey.c_str(), &db, flags_, tfile_, pageSize_)};
   if (rc != SQLITE_OK) {
     throw Exception{errors::FileOpenError}
       << "Failed to open requested DB, \"" << key << "\" of type, \""
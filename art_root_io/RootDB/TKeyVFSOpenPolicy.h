@@ -10,13 +10,16 @@ namespace art {
 
   class TKeyVFSOpenPolicy {
   public:
-    explicit TKeyVFSOpenPolicy(TFile* tfile, int flags = SQLITE_OPEN_READONLY);
+    explicit TKeyVFSOpenPolicy(TFile* tfile,
+                               int flags = SQLITE_OPEN_READONLY,
+                               int pageSize = 0);
 
     sqlite3* open(std::string const& key);
 
   private:
     TFile* tfile_;
     int flags_;
+    int pageSize_;
   };
 } // namespace art
 
@@ -18,11 +18,18 @@ using i64 = sqlite_int64;
 #include "TKey.h"
 #endif // TKEYVFS_NO_ROOT
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include <dlfcn.h>
@@ -59,6 +66,9 @@ namespace {
   // Externally provided ROOT file, must be open.
 #ifndef TKEYVFS_NO_ROOT
   TFile* gRootFile;
+  // Page size used for a newly-created database; zero means the
+  // database is saved as a single key.
+  int gPageSize;
 #endif // TKEYVFS_NO_ROOT
 
   constexpr i64 mem_page{2048};            // Memory page size
@@ -67,11 +77,16 @@ namespace {
 
   // The unixFile structure is subclass of sqlite3_file specific to the unix
   // VFS implementations.
+#ifndef TKEYVFS_NO_ROOT
+  class PagedDB;
+#endif // TKEYVFS_NO_ROOT
+
   struct unixFile {
     sqlite3_io_methods const* pMethod; //  Always the first entry
 #ifndef TKEYVFS_NO_ROOT
     TFile* rootFile;    //  The ROOT file the db is stored in
     int saveToRootFile; //  On close, save db to root file
+    PagedDB* paged;     //  Non-null if the db is stored as pages
 #endif                  // TKEYVFS_NO_ROOT
     char* pBuf;         //  File contents
     i64 bufAllocated;   //  File buffer size in bytes
@@ -92,6 +107,331 @@ namespace {
     unsigned char inNormalWrite; //  True if in a normal write operation
   };
 
+#ifndef TKEYVFS_NO_ROOT
+  // A paged database is stored in the ROOT file as an index key, with
+  // the name of the database, plus one key per page named
+  // "<name>_page_<n>".  The index records the page size and the size
+  // of the database; the title of the index key distinguishes it from
+  // a database stored as a single key.
+  constexpr char const* paged_index_title{"sqlite3 database page index"};
+  constexpr char const* paged_page_title{"sqlite3 database page"};
+  constexpr char paged_magic[8]{'T', 'K', 'V', 'F', 'S', 'P', 'G', '1'};
+  constexpr int paged_index_size{24};
+
+  void
+  put_i64(unsigned char* p, i64 const v)
+  {
+    for (int i = 0; i != 8; ++i) {
+      p[i] = static_cast<unsigned char>(static_cast<sqlite_uint64>(v) >>
+                                        (8 * i));
+    }
+  }
+
+  i64
+  get_i64(unsigned char const* p)
+  {
+    sqlite_uint64 v{};
+    for (int i = 0; i != 8; ++i) {
+      v |= static_cast<sqlite_uint64>(p[i]) << (8 * i);
+    }
+    return static_cast<i64>(v);
+  }
+
+  // Write nbytes of data as the contents of a new key.  If the key may
+  // already exist, its previous cycles are removed first.
+  bool
+  writeKey(TFile* file,
+           std::string const& name,
+           char const* title,
+           void const* data,
+           int const nbytes,
+           bool const replace)
+  {
+    if (replace) {
+      file->Delete((name + ";*").c_str());
+    }
+    //  Note: The tkey is owned by the root file.
+    auto k = new TKey{name.c_str(), title, TKey::Class(), nbytes, file};
+    int const cycle = file->AppendKey(k);
+    std::memcpy(k->GetBuffer(), data, static_cast<size_t>(nbytes));
+    return k->WriteFile(cycle, nullptr /*file*/) != -1;
+  }
+
+  // Read the contents of the key directly into dest, bypassing the
+  // i/o buffer of the key.
+  bool
+  readKey(TFile* file, TKey const* k, char* dest)
+  {
+    return !file->ReadBuffer(
+      dest, k->GetSeekKey() + k->GetKeylen(), k->GetObjlen());
+  }
+
+  // Database stored as fixed-size pages, each in its own key.  Pages
+  // are read lazily from the ROOT file; only pages that have been
+  // modified are held in memory, and only those are written on save.
+  class PagedDB {
+  public:
+    // Create a new, empty database.
+    PagedDB(TFile* file, std::string name, i64 pageSize);
+
+    // Open an existing database from its index key; returns nullptr if
+    // the index is not valid.
+    static std::unique_ptr<PagedDB> open(TFile* file,
+                                         TKey const* index,
+                                         std::string name);
+
+    i64
+    size() const
+    {
+      return size_;
+    }
+
+    // Return the number of bytes read, or -1 on error.
+    int read(void* buf, int amt, i64 offset);
+    bool write(void const* buf, int amt, i64 offset);
+    bool resize(i64 size);
+    bool save();
+
+  private:
+    PagedDB(TFile* file, std::string name, i64 pageSize, i64 size);
+
+    i64 nPages(i64 size) const;
+    std::string pageName(i64 n) const;
+    bool readPage(i64 n, char* dest) const;
+    char* dirtyPage(i64 n);
+
+    TFile* file_;
+    std::string name_;
+    i64 pageSize_;
+    i64 size_;
+    i64 diskPages_;   // Number of page keys in the ROOT file
+    i64 storedPages_; // Number of page keys whose contents are current
+    bool indexOnDisk_;
+    std::map<i64, std::unique_ptr<char[]>> dirty_{};
+    std::vector<char> cache_; // Most recently read clean page
+    i64 cachedPage_{-1};
+  };
+
+  PagedDB::PagedDB(TFile* const file, std::string name, i64 const pageSize)
+    : file_{file}
+    , name_{std::move(name)}
+    , pageSize_{pageSize}
+    , size_{0}
+    , diskPages_{0}
+    , storedPages_{0}
+    , indexOnDisk_{false}
+    , cache_(static_cast<size_t>(pageSize))
+  {}
+
+  PagedDB::PagedDB(TFile* const file,
+                   std::string name,
+                   i64 const pageSize,
+                   i64 const size)
+    : file_{file}
+    , name_{std::move(name)}
+    , pageSize_{pageSize}
+    , size_{size}
+    , diskPages_{nPages(size)}
+    , storedPages_{diskPages_}
+    , indexOnDisk_{true}
+    , cache_(static_cast<size_t>(pageSize))
+  {}
+
+  std::unique_ptr<PagedDB>
+  PagedDB::open(TFile* const file, TKey const* const index, std::string name)
+  {
+    if (index->GetObjlen() != paged_index_size) {
+      return nullptr;
+    }
+    unsigned char buf[paged_index_size];
+    if (!readKey(file, index, reinterpret_cast<char*>(buf)) ||
+        std::memcmp(buf, paged_magic, sizeof(paged_magic)) != 0) {
+      return nullptr;
+    }
+    i64 const pageSize = get_i64(buf + 8);
+    i64 const size = get_i64(buf + 16);
+    if (pageSize <= 0 || pageSize > std::numeric_limits<int>::max() ||
+        size < 0) {
+      return nullptr;
+    }
+    return std::unique_ptr<PagedDB>{
+      new PagedDB{file, std::move(name), pageSize, size}};
+  }
+
+  i64
+  PagedDB::nPages(i64 const size) const
+  {
+    return (size + pageSize_ - 1) / pageSize_;
+  }
+
+  std::string
+  PagedDB::pageName(i64 const n) const
+  {
+    return name_ + "_page_" + std::to_string(n);
+  }
+
+  // Pages that are not (or no longer) stored in the ROOT file read as
+  // zeroes, as does the part of a short last page beyond its key.
+  bool
+  PagedDB::readPage(i64 const n, char* dest) const
+  {
+    i64 len{};
+    if (n < storedPages_) {
+      auto const k = file_->GetKey(pageName(n).c_str());
+      if (k == nullptr || k->GetObjlen() > pageSize_ ||
+          !readKey(file_, k, dest)) {
+        return false;
+      }
+      len = k->GetObjlen();
+    }
+    std::memset(dest + len, 0, static_cast<size_t>(pageSize_ - len));
+    return true;
+  }
+
+  char*
+  PagedDB::dirtyPage(i64 const n)
+  {
+    auto it = dirty_.find(n);
+    if (it == dirty_.end()) {
+      std::unique_ptr<char[]> page{new (std::nothrow) char[pageSize_]};
+      if (!page || !readPage(n, page.get())) {
+        return nullptr;
+      }
+      it = dirty_.emplace(n, std::move(page)).first;
+      if (cachedPage_ == n) {
+        cachedPage_ = -1;
+      }
+    }
+    return it->second.get();
+  }
+
+  int
+  PagedDB::read(void* const buf, int amt, i64 const offset)
+  {
+    if (offset >= size_) {
+      return 0;
+    }
+    amt = static_cast<int>(std::min<i64>(amt, size_ - offset));
+    auto out = static_cast<char*>(buf);
+    for (int done = 0; done < amt;) {
+      i64 const n = (offset + done) / pageSize_;
+      i64 const pos = (offset + done) % pageSize_;
+      int const cnt =
+        static_cast<int>(std::min<i64>(pageSize_ - pos, amt - done));
+      if (auto it = dirty_.find(n); it != dirty_.end()) {
+        std::memcpy(
+          out + done, it->second.get() + pos, static_cast<size_t>(cnt));
+      } else if (cnt == pageSize_) {
+        // A whole clean page: read it straight into the caller's buffer.
+        if (!readPage(n, out + done)) {
+          return -1;
+        }
+      } else {
+        if (cachedPage_ != n) {
+          cachedPage_ = -1;
+          if (!readPage(n, cache_.data())) {
+            return -1;
+          }
+          cachedPage_ = n;
+        }
+        std::memcpy(out + done, cache_.data() + pos, static_cast<size_t>(cnt));
+      }
+      done += cnt;
+    }
+    return amt;
+  }
+
+  bool
+  PagedDB::write(void const* const buf, int const amt, i64 const offset)
+  {
+    auto in = static_cast<char const*>(buf);
+    for (int done = 0; done < amt;) {
+      i64 const n = (offset + done) / pageSize_;
+      i64 const pos = (offset + done) % pageSize_;
+      int const cnt =
+        static_cast<int>(std::min<i64>(pageSize_ - pos, amt - done));
+      char* page = dirtyPage(n);
+      if (page == nullptr) {
+        return false;
+      }
+      std::memcpy(page + pos, in + done, static_cast<size_t>(cnt));
+      done += cnt;
+    }
+    size_ = std::max(size_, offset + amt);
+    return true;
+  }
+
+  bool
+  PagedDB::resize(i64 const size)
+  {
+    if (size < size_) {
+      i64 const keep = nPages(size);
+      dirty_.erase(dirty_.lower_bound(keep), dirty_.end());
+      storedPages_ = std::min(storedPages_, keep);
+      if (cachedPage_ >= keep) {
+        cachedPage_ = -1;
+      }
+      // The tail of a partially truncated page must read as zeroes if
+      // the database is extended again.
+      if (i64 const pos = size % pageSize_; pos != 0) {
+        char* page = dirtyPage(size / pageSize_);
+        if (page == nullptr) {
+          return false;
+        }
+        std::memset(page + pos, 0, static_cast<size_t>(pageSize_ - pos));
+      }
+    }
+    size_ = size;
+    return true;
+  }
+
+  bool
+  PagedDB::save()
+  {
+    bool ok{true};
+    i64 const pages = nPages(size_);
+    std::vector<char> zeroes;
+    for (i64 n = 0; n != pages; ++n) {
+      int const len =
+        static_cast<int>(std::min(pageSize_, size_ - n * pageSize_));
+      char const* data{nullptr};
+      if (auto it = dirty_.find(n); it != dirty_.end()) {
+        data = it->second.get();
+      } else if (n >= storedPages_) {
+        zeroes.resize(static_cast<size_t>(pageSize_));
+        data = zeroes.data();
+      } else {
+        continue; // Unchanged page already in the ROOT file.
+      }
+      ok = writeKey(file_,
+                    pageName(n),
+                    paged_page_title,
+                    data,
+                    len,
+                    n < diskPages_) &&
+           ok;
+    }
+    for (i64 n = pages; n < diskPages_; ++n) {
+      file_->Delete((pageName(n) + ";*").c_str());
+    }
+    unsigned char index[paged_index_size];
+    std::memcpy(index, paged_magic, sizeof(paged_magic));
+    put_i64(index + 8, pageSize_);
+    put_i64(index + 16, size_);
+    ok = writeKey(file_,
+                  name_,
+                  paged_index_title,
+                  index,
+                  paged_index_size,
+                  indexOnDisk_) &&
+         ok;
+    dirty_.clear();
+    diskPages_ = storedPages_ = pages;
+    indexOnDisk_ = true;
+    return ok;
+  }
+#endif // TKEYVFS_NO_ROOT
+
   int sqlite3CantopenError(int lineno);
 
   // VFS calls
@@ -288,7 +628,18 @@ namespace {
 #endif // TKEYVFS_NO_ROOT
 #endif // TKEYVFS_TRACE
 #ifndef TKEYVFS_NO_ROOT
-    if (pFile->saveToRootFile) {
+    if (pFile->saveToRootFile && pFile->paged != nullptr) {
+      // Only the pages modified since the database was opened are
+      // written.
+      if (!pFile->paged->save()) {
+        fprintf(stderr,
+                "tkeyvfs: failed to write root tkeys containing database "
+                "pages to root file!\n");
+      }
+      if (pFile->rootFile->Write("", TObject::kOverwrite) < 0) {
+        fprintf(stderr, "tkeyvfs: failed to write root file to disk!\n");
+      }
+    } else if (pFile->saveToRootFile) {
 #if TKEYVFS_TRACE
       fprintf(stderr, "fileSize: 0x%016lx\n", pFile->fileSize);
 #endif // TKEYVFS_TRACE
@@ -330,6 +681,7 @@ namespace {
         fprintf(stderr, "tkeyvfs: failed to write root file to disk!\n");
       }
     }
+    delete pFile->paged;
 #endif // TKEYVFS_NO_ROOT
     if (pFile->pBuf != nullptr) {
       free(pFile->pBuf);
@@ -386,6 +738,15 @@ namespace {
     if (pFile->szChunk) {
       i64 nSize = ((nByte + (pFile->szChunk - 1)) / pFile->szChunk) *
                   pFile->szChunk; // Required file size
+#ifndef TKEYVFS_NO_ROOT
+      if (pFile->paged != nullptr) {
+        if (nSize > pFile->fileSize) {
+          pFile->paged->resize(nSize);
+          pFile->fileSize = nSize;
+        }
+        return SQLITE_OK;
+      }
+#endif // TKEYVFS_NO_ROOT
       i64 nAlloc = ((nSize + (mem_page - 1)) / mem_page) * mem_page;
       if ((nSize > pFile->fileSize) && (nAlloc > pFile->bufAllocated)) {
         if (nAlloc > pFile->bufAllocated) {
@@ -423,6 +784,12 @@ namespace {
   seekAndRead(unixFile* id, sqlite3_int64 offset, void* pBuf, int cnt)
   {
     Trace tr{"seekAndRead"};
+#ifndef TKEYVFS_NO_ROOT
+    if (id->paged != nullptr) {
+      id->lastErrno = 0;
+      return id->paged->read(pBuf, cnt, offset);
+    }
+#endif // TKEYVFS_NO_ROOT
     if (offset >= id->fileSize) {
       id->lastErrno = 0;
       return 0;
@@ -444,6 +811,16 @@ namespace {
   {
     Trace tr{"seekAndWrite"};
     unixFile* pFile = (unixFile*)id;
+#ifndef TKEYVFS_NO_ROOT
+    if (id->paged != nullptr) {
+      if (!id->paged->write(pBuf, cnt, offset)) {
+        id->lastErrno = errno;
+        return -1;
+      }
+      id->fileSize = id->paged->size();
+      return cnt;
+    }
+#endif // TKEYVFS_NO_ROOT
     if ((offset + cnt) > id->bufAllocated) {
       i64 nByte = offset + static_cast<i64>(cnt);
       if (pFile->szChunk) {
@@ -594,6 +971,19 @@ namespace {
     if (pFile->szChunk) {
       nByte = ((nByte + pFile->szChunk - 1) / pFile->szChunk) * pFile->szChunk;
     }
+#ifndef TKEYVFS_NO_ROOT
+    if (pFile->paged != nullptr) {
+      if (!pFile->paged->resize(nByte)) {
+        pFile->lastErrno = errno;
+        return unixLogError(SQLITE_IOERR_TRUNCATE, "ftruncate", pFile->zPath);
+      }
+      pFile->fileSize = nByte;
+      if (pFile->inNormalWrite && (nByte == 0)) {
+        pFile->transCntrChng = 1;
+      }
+      return SQLITE_OK;
+    }
+#endif // TKEYVFS_NO_ROOT
     if (nByte == 0) {
       free(pFile->pBuf);
       pFile->pBuf = (char*)calloc(1, mem_page);
@@ -955,6 +1345,20 @@ namespace {
       // Read the highest numbered cycle of the tkey which contains
       // the database from the root file.
       TKey* k = p->rootFile->GetKey(p->zPath, 9999 /*cycle*/);
+      if (k == nullptr) {
+        rc = unixLogError(SQLITE_CANTOPEN_BKPT, "open", zName);
+        return rc;
+      }
+      if (std::strcmp(k->GetTitle(), paged_index_title) == 0) {
+        // The database is stored as pages, which are read on demand.
+        p->paged = PagedDB::open(p->rootFile, k, p->zPath).release();
+        if (p->paged == nullptr) {
+          rc = unixLogError(SQLITE_CANTOPEN_BKPT, "open", zName);
+          return rc;
+        }
+        p->fileSize = p->paged->size();
+        return SQLITE_OK;
+      }
       // Force the tkey to allocate an i/o buffer for its contents.
       k->SetBuffer();
       // Read the contents of the tkey from the root file.
@@ -994,6 +1398,17 @@ namespace {
       p->bufAllocated = nAlloc;
       p->fileSize = nBytes;
     } else {
+#ifndef TKEYVFS_NO_ROOT
+      if (p->saveToRootFile && gPageSize > 0) {
+        p->paged = new (std::nothrow) PagedDB{p->rootFile, p->zPath, gPageSize};
+        if (p->paged == nullptr) {
+          rc = unixLogError(SQLITE_CANTOPEN_BKPT, "open", zName);
+          return rc;
+        }
+        p->fileSize = 0;
+        return SQLITE_OK;
+      }
+#endif // TKEYVFS_NO_ROOT
       p->pBuf = (char*)calloc(1, mem_page);
       if (p->pBuf == nullptr) {
 #if TKEYVFS_TRACE
@@ -1259,8 +1674,16 @@ namespace {
 #ifndef TKEYVFS_NO_ROOT
   class RootFileSentry {
   public:
-    explicit RootFileSentry(TFile* const fPtr) noexcept { gRootFile = fPtr; }
-    ~RootFileSentry() noexcept { gRootFile = nullptr; }
+    RootFileSentry(TFile* const fPtr, int const pageSize) noexcept
+    {
+      gRootFile = fPtr;
+      gPageSize = pageSize;
+    }
+    ~RootFileSentry() noexcept
+    {
+      gRootFile = nullptr;
+      gPageSize = 0;
+    }
   };
 #endif
 }
@@ -1309,10 +1732,11 @@ int
 tkeyvfs_open_v2(char const* filename, // Database filename (UTF-8)
                 sqlite3** ppDb,       // OUT: SQLite db handle
                 int const flags,      // Flags
-                TFile* rootFile // IN-OUT: Root file, must be already open.
+                TFile* rootFile, // IN-OUT: Root file, must be already open.
+                int const pageSize // Page size for a new db, 0 for one key
 )
 {
-  RootFileSentry rfs{rootFile};
+  RootFileSentry rfs{rootFile, pageSize};
   // Note that the sentry *is* the correct thing to do, here:
   // gRootFile is required in unixOpen(), which is called as part of
   // the chain of functions of which sqlite3_open_v2() is the first
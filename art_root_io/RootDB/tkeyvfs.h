@@ -6,10 +6,15 @@ class TFile;
 
 int tkeyvfs_init();
 int tkeyvfs_open_v2_noroot(char const* filename, sqlite3** ppDb, int flags);
+// If pageSize is non-zero, a newly-created database is saved as keys
+// of pageSize bytes each, rather than as a single key.  Pages of such
+// a database are read on demand, and only modified pages are written
+// when it is closed.  Databases of either layout can be opened.
 int tkeyvfs_open_v2(char const* filename,
                     sqlite3** ppDb,
                     int flags,
-                    TFile* rootFile);
+                    TFile* rootFile,
+                    int pageSize = 0);
 
 #endif /* art_root_io_RootDB_tkeyvfs_h */
 
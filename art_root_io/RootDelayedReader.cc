@@ -4,7 +4,7 @@
 #include "art/Framework/Core/InputSourceMutex.h"
 #include "art/Framework/Principal/Principal.h"
 #include "art/Framework/Principal/RangeSetsSupported.h"
-#include "art_root_io/detail/resolveRangeSet.h"
+#include "art_root_io/detail/RangeSetResolver.h"
 #include "canvas/Persistency/Provenance/BranchDescription.h"
 #include "canvas/Persistency/Provenance/Compatibility/BranchIDList.h"
 #include "canvas/Persistency/Provenance/ProductProvenance.h"
@@ -13,9 +13,12 @@
 #include "canvas_root_io/Streamers/RefCoreStreamer.h"
 
 #include "TBranch.h"
-#include "TClass.h"
+#include "TFile.h"
+#include "TTree.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <utility>
 #include <vector>
 
@@ -23,11 +26,16 @@ using namespace std;
 
 namespace art {
 
-  RootDelayedReader::~RootDelayedReader() = default;
+  RootDelayedReader::~RootDelayedReader()
+  {
+    if (completedPrincipals_) {
+      ++*completedPrincipals_;
+    }
+  }
 
   RootDelayedReader::RootDelayedReader(
     FileFormatVersion const version,
-    sqlite3* db,
+    cet::exempt_ptr<detail::RangeSetResolver> rangeSetResolver,
     vector<input::EntryNumber> const& entrySet,
     cet::exempt_ptr<input::BranchMap const> branches,
     TBranch* provenanceBranch,
@@ -36,9 +44,11 @@ namespace art {
     cet::exempt_ptr<BranchIDLists const> bidLists,
     BranchType const branchType,
     EventID const eID,
-    bool const compactSubRunRanges)
+    bool const timeReads,
+    bool const timeLockWaits,
+    cet::exempt_ptr<std::atomic<std::size_t>> completedPrincipals)
     : fileFormatVersion_{version}
-    , db_{db}
+    , rangeSetResolver_{rangeSetResolver}
     , entrySet_{entrySet}
     , branches_{branches}
     , provenanceBranch_{provenanceBranch}
@@ -47,7 +57,9 @@ namespace art {
     , branchIDLists_{bidLists}
     , branchType_{branchType}
     , eventID_{eID}
-    , compactSubRunRanges_{compactSubRunRanges}
+    , timeReads_{timeReads}
+    , timeLockWaits_{timeLockWaits}
+    , completedPrincipals_{completedPrincipals}
   {}
 
   void
@@ -89,20 +101,8 @@ namespace art {
     }
     {
       InputSourceMutexSentry sentry;
-      for (auto const entryNum : entrySet_) {
-        vector<ProductProvenance> ppv;
-        ProductProvenance const* prov = nullptr;
-        {
-          auto p_ppv = &ppv;
-          provenanceBranch_->SetAddress(&p_ppv);
-          input::getEntry(provenanceBranch_, entryNum);
-          for (auto const& val : ppv) {
-            if (val.productID() == bid) {
-              prov = &val;
-              break;
-            }
-          }
-        }
+      for (std::size_t i = 0, n = entrySet_.size(); i != n; ++i) {
+        auto const prov = fragmentProvenance(i, bid);
         // Note: If this is a produced product then it might not be in
         // any of the fragments, this is not an error.
         if (prov != nullptr) {
@@ -119,6 +119,35 @@ namespace art {
     }
   }
 
+  ProductProvenance const*
+  RootDelayedReader::fragmentProvenance(std::size_t const fragment,
+                                        ProductID const pid) const
+  {
+    if (fragmentProvenance_.empty()) {
+      fragmentProvenance_.resize(entrySet_.size());
+    }
+    auto& ppv = fragmentProvenance_[fragment];
+    if (!ppv) {
+      auto& decoded = ppv.emplace();
+      auto p_ppv = &decoded;
+      provenanceBranch_->SetAddress(&p_ppv);
+      input::getEntry(provenanceBranch_, entrySet_[fragment]);
+      // Stable, so that the first of any duplicate entries is found.
+      std::stable_sort(
+        decoded.begin(), decoded.end(), [](auto const& a, auto const& b) {
+          return a.productID() < b.productID();
+        });
+    }
+    auto const it = std::lower_bound(
+      ppv->cbegin(), ppv->cend(), pid, [](auto const& prov, ProductID id) {
+        return prov.productID() < id;
+      });
+    if (it == ppv->cend() || it->productID() != pid) {
+      return nullptr;
+    }
+    return &*it;
+  }
+
   namespace {
     class ConfigureStreamersSentry {
     public:
@@ -160,14 +189,39 @@ namespace art {
     }
     // Note: threading: The configure ref core streamer and the related i/o
     // operations must be done with the source lock held!
+    std::optional<std::chrono::steady_clock::time_point> lockRequested;
+    if (timeLockWaits_) {
+      lockRequested = std::chrono::steady_clock::now();
+    }
     InputSourceMutexSentry sentry;
+    if (lockRequested) {
+      branchInfo.readStats_.lockWait +=
+        std::chrono::steady_clock::now() - *lockRequested;
+    }
     ConfigureStreamersSentry streamers_sentry{branchIDLists_, principal_};
-    TClass* cl = TClass::GetClass(pd.wrappedName().c_str());
-    auto get_product = [this, cl, br](auto entry) {
-      unique_ptr<EDProduct> p{static_cast<EDProduct*>(cl->New())};
+    auto get_product = [this, br, &branchInfo](auto entry) {
+      // The branch may have been deactivated because the product was
+      // not read during the warm-up window of the input file.
+      branchInfo.setActive(true);
+      unique_ptr<EDProduct> p{branchInfo.newProduct()};
       EDProduct* pp = p.get();
       br->SetAddress(&pp);
+      auto const file = br->GetTree()->GetCurrentFile();
+      auto const readCalls = file->GetReadCalls();
+      std::optional<std::chrono::steady_clock::time_point> start;
+      if (timeReads_) {
+        start = std::chrono::steady_clock::now();
+      }
       auto const bytesRead = input::getEntry(br, entry);
+      auto& stats = branchInfo.readStats_;
+      ++stats.reads;
+      stats.bytes += bytesRead > 0 ? bytesRead : 0;
+      if (start) {
+        stats.stallTime += std::chrono::steady_clock::now() - *start;
+      }
+      if (file->GetReadCalls() == readCalls) {
+        ++stats.cacheHits;
+      }
       if ((saveMemoryObjectThreshold_ > -1) &&
           (bytesRead > saveMemoryObjectThreshold_)) {
         br->DropBaskets("all");
@@ -194,20 +248,6 @@ namespace art {
       }
       return result;
     }
-    // Fetch the provenance for the first product.
-    vector<ProductProvenance> ppv;
-    unique_ptr<ProductProvenance const> prov;
-    {
-      auto p_ppv = &ppv;
-      provenanceBranch_->SetAddress(&p_ppv);
-      input::getEntry(provenanceBranch_, entrySet_[0]);
-      for (auto const& val : ppv) {
-        if (val.productID() == pid) {
-          prov.reset(new ProductProvenance(val));
-          break;
-        }
-      }
-    }
     // Note: Cannot make this assert here because it can be so that the first
     // product
     //       is a dummy wrapper with the present flag false, and no provenance
@@ -219,12 +259,9 @@ namespace art {
     // this case because products that represent a full (Sub)Run are
     // allowed to be duplicated in an input file.  The behavior in
     // such a case is a NOP.
-    assert(db_ != nullptr);
-    RangeSet mergedRangeSet = detail::resolveRangeSet(db_,
-                                                      "SomeInput"s,
-                                                      branchType_,
-                                                      result->getRangeSetID(),
-                                                      compactSubRunRanges_);
+    assert(rangeSetResolver_);
+    RangeSet mergedRangeSet =
+      rangeSetResolver_->rangeSet(branchType_, result->getRangeSetID());
     // Note: If the mergedRangeSet is invalid here that means the first product
     // was a dummy created
     //       by RootOutputFile to prevent double-counting when combining
@@ -232,29 +269,13 @@ namespace art {
     //       by intentionally created a product with an invalid range set.
     // Note: Also in that case we have a product status of unknown which we may
     // have to replace later.
-    for (auto it = entrySet_.cbegin() + 1, e = entrySet_.cend(); it != e;
-         ++it) {
-      auto p = get_product(*it);
-      vector<ProductProvenance> new_ppv;
-      unique_ptr<ProductProvenance const> new_prov;
-      {
-        auto p_ppv = &new_ppv;
-        provenanceBranch_->SetAddress(&p_ppv);
-        input::getEntry(provenanceBranch_, *it);
-        for (auto const& val : new_ppv) {
-          if (val.productID() == pid) {
-            new_prov.reset(new ProductProvenance(val));
-            break;
-          }
-        }
-      }
+    for (std::size_t i = 1, n = entrySet_.size(); i != n; ++i) {
+      auto p = get_product(entrySet_[i]);
+      auto const new_prov = fragmentProvenance(i, pid);
       // assert((new_prov.get() != nullptr) && "Could not find provenance for
       // this Run/SubRun product!");  auto const id = p->getRangeSetID();
-      RangeSet const& newRS = detail::resolveRangeSet(db_,
-                                                      "SomeInput"s,
-                                                      branchType_,
-                                                      p->getRangeSetID(),
-                                                      compactSubRunRanges_);
+      RangeSet const& newRS =
+        rangeSetResolver_->rangeSet(branchType_, p->getRangeSetID());
       if (!mergedRangeSet.is_valid() && !newRS.is_valid()) {
         // Both range sets are invalid, do nothing.
         // RootOutputFile creates this situation to prevent double-counting when
@@ -278,7 +299,6 @@ namespace art {
         // newRS is valid.
         const_cast<Group*>(grp)->setProductProvenance(
           make_unique<ProductProvenance const>(*new_prov));
-        prov = std::move(new_prov);
       } else if (art::disjoint_ranges(mergedRangeSet, newRS)) {
         // Old and new range sets can be combined, do it.
         // FIXME: Can a neverCreated or dropped product have a valid range set?
@@ -11,10 +11,12 @@
 #include "canvas/Persistency/Provenance/FileFormatVersion.h"
 #include "canvas/Persistency/Provenance/RangeSet.h"
 #include "canvas/Persistency/Provenance/fwd.h"
+#include "cetlib/exempt_ptr.h"
 
+#include <atomic>
 #include <memory>
-
-struct sqlite3;
+#include <optional>
+#include <vector>
 
 class TBranch;
 
@@ -25,6 +27,9 @@ namespace art {
   class Group;
   class Principal;
   class ProductProvenance;
+  namespace detail {
+    class RangeSetResolver;
+  }
 
   class RootDelayedReader final : public DelayedReader {
   public:
@@ -34,7 +39,7 @@ namespace art {
     RootDelayedReader(RootDelayedReader&&) = delete;
     RootDelayedReader& operator=(RootDelayedReader&&) = delete;
     RootDelayedReader(FileFormatVersion,
-                      sqlite3* db,
+                      cet::exempt_ptr<detail::RangeSetResolver>,
                       std::vector<input::EntryNumber> const& entrySet,
                       cet::exempt_ptr<input::BranchMap const>,
                       TBranch* provenanceBranch,
@@ -43,7 +48,10 @@ namespace art {
                       cet::exempt_ptr<BranchIDLists const> branchIDLists,
                       BranchType branchType,
                       EventID,
-                      bool compactSubRunRanges);
+                      bool timeReads = false,
+                      bool timeLockWaits = false,
+                      cet::exempt_ptr<std::atomic<std::size_t>>
+                        completedPrincipals = nullptr);
 
   private:
     std::unique_ptr<EDProduct> getProduct_(Group const*,
@@ -54,8 +62,14 @@ namespace art {
     bool isAvailableAfterCombine_(ProductID) const override;
     std::unique_ptr<Principal> readFromSecondaryFile_(int& idx) override;
 
+    // Provenance of the product 'pid' in the given run or subrun
+    // fragment (an index into entrySet_), or null if there is none.
+    // Must be called with the input-source lock held.
+    ProductProvenance const* fragmentProvenance(std::size_t fragment,
+                                                ProductID pid) const;
+
     FileFormatVersion fileFormatVersion_;
-    sqlite3* db_;
+    cet::exempt_ptr<detail::RangeSetResolver> rangeSetResolver_;
     std::vector<input::EntryNumber> const entrySet_;
     cet::exempt_ptr<input::BranchMap const> branches_;
     TBranch* provenanceBranch_;
@@ -65,7 +79,19 @@ namespace art {
     cet::exempt_ptr<BranchIDLists const> branchIDLists_;
     BranchType branchType_;
     EventID eventID_;
-    bool const compactSubRunRanges_;
+    // Whether the reads of products, and the waits for the input-source
+    // lock, are timed in the read statistics of their branches.
+    bool const timeReads_;
+    bool const timeLockWaits_;
+    // Incremented, if given, when this reader is destroyed with its
+    // principal, i.e. once the principal has been processed.
+    cet::exempt_ptr<std::atomic<std::size_t>> completedPrincipals_;
+    // Provenance of each run or subrun fragment, sorted by product ID.
+    // A fragment is decoded the first time any of its products is
+    // looked up, and shared by the reads of all products of the
+    // principal.
+    mutable std::vector<std::optional<std::vector<ProductProvenance>>>
+      fragmentProvenance_{};
   };
 } // namespace art
 
@@ -15,6 +15,9 @@
 class TTree;
 
 namespace art {
+  namespace detail {
+    class RangeSetResolver;
+  }
 
   class RootFileBlock : public FileBlock {
   public:
@@ -22,11 +25,24 @@ namespace art {
                   std::string const& fileName,
                   std::unique_ptr<ResultsPrincipal>&& resp,
                   cet::exempt_ptr<TTree const> ev,
-                  FastCloningEnabled fastCopy)
+                  FastCloningEnabled fastCopy,
+                  cet::exempt_ptr<TTree const> subRuns = nullptr,
+                  cet::exempt_ptr<TTree const> runs = nullptr,
+                  cet::exempt_ptr<detail::RangeSetResolver> rangeSets = nullptr,
+                  FastCloningEnabled fastCopyRunsAndSubRuns = {})
       : FileBlock{version, fileName, std::move(resp)}
       , tree_{ev}
+      , subRunTree_{subRuns}
+      , runTree_{runs}
+      , rangeSetResolver_{rangeSets}
       , fastCopyable_{std::move(fastCopy)}
-    {}
+      , runsAndSubRunsFastCopyable_{std::move(fastCopyRunsAndSubRuns)}
+    {
+      if (!subRunTree_ || !runTree_ || !rangeSetResolver_) {
+        runsAndSubRunsFastCopyable_.disable(
+          "The run and subrun trees of the input file are not available.");
+      }
+    }
 
     cet::exempt_ptr<TTree const>
     tree() const
@@ -38,10 +54,35 @@ namespace art {
     {
       return fastCopyable_;
     }
+    cet::exempt_ptr<TTree const>
+    subRunTree() const
+    {
+      return subRunTree_;
+    }
+    cet::exempt_ptr<TTree const>
+    runTree() const
+    {
+      return runTree_;
+    }
+    // Resolves the RangeSet IDs of the run and subrun products.
+    cet::exempt_ptr<detail::RangeSetResolver>
+    rangeSetResolver() const
+    {
+      return rangeSetResolver_;
+    }
+    FastCloningEnabled const&
+    runsAndSubRunsFastClonable() const noexcept
+    {
+      return runsAndSubRunsFastCopyable_;
+    }
 
   private:
-    cet::exempt_ptr<TTree const> tree_; // ROOT owns the tree
+    cet::exempt_ptr<TTree const> tree_; // ROOT owns the trees
+    cet::exempt_ptr<TTree const> subRunTree_;
+    cet::exempt_ptr<TTree const> runTree_;
+    cet::exempt_ptr<detail::RangeSetResolver> rangeSetResolver_;
     FastCloningEnabled fastCopyable_;
+    FastCloningEnabled runsAndSubRunsFastCopyable_;
   };
 } // namespace art
 
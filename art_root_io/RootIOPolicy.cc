@@ -7,11 +7,37 @@
 #include "canvas_root_io/Streamers/ProductIDStreamer.h"
 #include "canvas_root_io/Streamers/RefCoreStreamer.h"
 #include "canvas_root_io/Utilities/DictionaryChecker.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include "TDirectory.h"
 #include "TTree.h"
+#include "TTreeCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <optional>
 
 namespace {
+  // The distinct entries of 'seq', in increasing order, so that each
+  // entry is read once and the reads move forward through the tree.
+  art::EntryNumberSequence
+  sortedEntries(art::EntryNumberSequence seq)
+  {
+    std::sort(seq.begin(), seq.end());
+    seq.erase(std::unique(seq.begin(), seq.end()), seq.end());
+    return seq;
+  }
+
+  std::size_t
+  indexOf(art::EntryNumberSequence const& sorted,
+          art::EntryNumberSequence::value_type const entry)
+  {
+    auto const it = std::lower_bound(sorted.cbegin(), sorted.cend(), entry);
+    assert(it != sorted.cend() && *it == entry);
+    return std::distance(sorted.cbegin(), it);
+  }
+
   std::array<cet::exempt_ptr<TTree>, art::NumBranchTypes>
   initDataTrees(TFile& currentFile)
   {
@@ -30,93 +56,162 @@ namespace {
   }
 }
 
-void
-art::RootIOPolicy::openAndReadMetaData(std::string filename, MixOpList& mixOps)
+art::RootIOPolicy::RootIOPolicy() = default;
+
+art::RootIOPolicy::RootIOPolicy(std::vector<std::string> const& fileNames,
+                                Long64_t const treeCacheSize)
+  : treeCacheSize_{treeCacheSize}
+{
+  if (treeCacheSize_ < 0) {
+    throw Exception(errors::Configuration)
+      << "The TTreeCache size of a RootIOPolicy, " << treeCacheSize_
+      << ", is negative.\n";
+  }
+  if (fileNames.size() < 2) {
+    return;
+  }
+  for (std::size_t i = 0, n = fileNames.size(); i != n; ++i) {
+    nextFileNames_[fileNames[i]] = fileNames[(i + 1) % n];
+  }
+}
+
+art::RootIOPolicy::~RootIOPolicy()
+{
+  waitForPrefetch();
+  discardNextFile();
+}
+
+art::RootIOPolicy::OpenedFile
+art::RootIOPolicy::openFile(std::string const& filename)
 {
-  // FIXME: this should be switched to a ROOT-specific mutex as
-  // necessary.
-  InputSourceMutexSentry sentry;
-  // The following 'context' variable is necessary to ensure that the
-  // file will be closed on the same thread on which it is created.
-  // This should not be necessary once the following issue is
-  // addressed -- https://github.com/root-project/root/issues/6939.
+  // The following 'context' variable restores the current directory of
+  // this thread once the file is open, so that the file may be closed
+  // on another thread.  This should not be necessary once the
+  // following issue is addressed --
+  // https://github.com/root-project/root/issues/6939.
   TDirectory::TContext context;
+  OpenedFile result;
   // Open file.
   try {
-    currentFile_.reset(TFile::Open(filename.c_str()));
+    result.file.reset(TFile::Open(filename.c_str()));
   }
   catch (std::exception const& e) {
     throw Exception(errors::FileOpenError, e.what())
       << "Unable to open specified secondary event stream file " << filename
       << ".\n";
   }
-  if (!currentFile_ || currentFile_->IsZombie()) {
+  if (!result.file || result.file->IsZombie()) {
     throw Exception(errors::FileOpenError)
       << "Unable to open specified secondary event stream file " << filename
       << ".\n";
   }
   // Obtain meta data tree.
-  currentMetaDataTree_.reset(
-    currentFile_->Get<TTree>(rootNames::metaDataTreeName().c_str()));
-  if (currentMetaDataTree_.get() == nullptr) {
+  result.metaDataTree.reset(
+    result.file->Get<TTree>(rootNames::metaDataTreeName().c_str()));
+  if (result.metaDataTree.get() == nullptr) {
     throw Exception(errors::FileReadError)
       << "Unable to read meta data tree from secondary event stream file "
       << filename << ".\n";
   }
-  currentDataTrees_ = initDataTrees(*currentFile_);
-  auto nevents = currentDataTrees_[InEvent]->GetEntries();
+  result.dataTrees = initDataTrees(*result.file);
+  auto nevents = result.dataTrees[InEvent]->GetEntries();
   if (nevents < 0) {
     throw Exception(errors::FileReadError)
       << "Error when retrieving number of entries in event tree for file "
       << filename << ".\n";
   }
   assert(nevents >= 0);
-  nEventsInCurrentFile_ = static_cast<std::size_t>(nevents);
+  result.nEvents = static_cast<std::size_t>(nevents);
 
   // Read file index
-  FileIndex* fileIndexPtr = &fileIndexInCurrentFile_;
+  FileIndex* fileIndexPtr = &result.fileIndex;
   detail::readFileIndex(
-    currentFile_.get(), currentMetaDataTree_.get(), fileIndexPtr);
+    result.file.get(), result.metaDataTree.get(), fileIndexPtr);
 
   // To support files that contain BranchIDLists
   BranchIDLists branchIDLists{};
-  if (detail::readMetadata(currentMetaDataTree_.get(), branchIDLists)) {
-    branchIDListsInCurrentFile_ =
+  if (detail::readMetadata(result.metaDataTree.get(), branchIDLists)) {
+    result.branchIDLists =
       std::make_unique<BranchIDLists>(std::move(branchIDLists));
-    configureProductIDStreamer(branchIDListsInCurrentFile_.get());
   }
 
   // Check file format era.
-  ffVersion_ =
-    detail::readMetadata<FileFormatVersion>(currentMetaDataTree_.get());
+  result.ffVersion =
+    detail::readMetadata<FileFormatVersion>(result.metaDataTree.get());
 
   std::string const expected_era = getFileFormatEra();
-  if (ffVersion_.era_ != expected_era) {
+  if (result.ffVersion.era_ != expected_era) {
     throw Exception(errors::FileReadError)
       << "Can only read files written during the \"" << expected_era
       << "\" era: "
       << "Era of "
       << "\"" << filename << "\" was "
-      << (ffVersion_.era_.empty() ? "not set" :
-                                    ("set to \"" + ffVersion_.era_ + "\" "))
+      << (result.ffVersion.era_.empty() ?
+            "not set" :
+            ("set to \"" + result.ffVersion.era_ + "\" "))
       << ".\n";
   }
   auto dbCount = 0;
-  for (auto const tree : currentDataTrees_) {
+  for (auto const tree : result.dataTrees) {
     if (tree.get()) {
-      dataBranches_[dbCount].reset(tree.get());
+      result.dataBranches[dbCount].reset(tree.get());
     }
     ++dbCount;
   }
+  return result;
+}
 
-  branchInfos_.clear();
+void
+art::RootIOPolicy::discardNextFile()
+{
+  if (!nextFile_.valid()) {
+    return;
+  }
+  // An error that occurred while opening a file that is not used is of
+  // no interest.
+  try {
+    nextFile_.get();
+  }
+  catch (...) {
+  }
+}
+
+void
+art::RootIOPolicy::openAndReadMetaData(std::string filename, MixOpList& mixOps)
+{
+  waitForPrefetch();
+  // ROOT's thread safety is enabled (see setup.cc), and nothing read
+  // from the new file until it is swapped in goes through the RefCore
+  // or ProductID streamers, which are configured for the whole
+  // process.  The file is therefore opened, indexed and matched against
+  // the mix operations without the input-source lock, whether in the
+  // background or here.
+  std::optional<OpenedFile> opened;
+  if (nextFile_.valid() && nextFileName_ == filename) {
+    opened = nextFile_.get();
+    mf::LogInfo("RootIOPolicy")
+      << "Secondary file " << filename << " was opened in the background.";
+  } else {
+    discardNextFile();
+    opened = openFile(filename);
+  }
+
+  std::map<ProductID, RootBranchInfo> branchInfos;
+  ProductID lastMixedProduct{};
+  auto const eventTree = opened->dataTrees[InEvent];
+  bool const cached = treeCacheSize_ > 0;
+  if (cached) {
+    eventTree->SetCacheSize(treeCacheSize_);
+    eventTree->AddBranchToCache(
+      BranchTypeToAuxiliaryBranchName(InEvent).c_str(), false);
+  }
   root::DictionaryChecker checker{};
   for (auto& op : mixOps) {
     auto const bt = op->branchType();
     RootBranchInfo info{};
     auto const iType = op->inputType();
     auto const success =
-      dataBranches_[bt].findBranchInfo(iType, op->inputTag(), info);
+      opened->dataBranches[bt].findBranchInfo(iType, op->inputTag(), info);
     if (!success) {
       throw Exception(errors::ProductNotFound)
         << "Unable to find requested product " << op->inputTag() << " of type "
@@ -124,43 +219,95 @@ art::RootIOPolicy::openAndReadMetaData(std::string filename, MixOpList& mixOps)
     }
     ProductID prodID{info.branchName()};
     op->setIncomingProductID(prodID);
-    branchInfos_.emplace(std::move(prodID), std::move(info));
+    if (cached && bt == InEvent) {
+      eventTree->AddBranchToCache(info.branch(), true);
+    }
+    lastMixedProduct = prodID;
+    branchInfos.emplace(std::move(prodID), std::move(info));
     // Check dictionaries for input product, not output product: let
-    // output modules take care of that.
-    checker.checkDictionaries(iType.className());
+    // output modules take care of that.  The products do not depend on
+    // the file, so this is done only once.
+    if (!dictionariesChecked_) {
+      checker.checkDictionaries(iType.className());
+    }
   }
   checker.reportMissingDictionaries();
+  dictionariesChecked_ = true;
+  // Only the mixed branches are ever read from the event tree.
+  if (cached) {
+    eventTree->StopCacheLearningPhase();
+  }
+
+  {
+    InputSourceMutexSentry sentry;
+    currentFile_ = std::move(opened->file);
+    currentMetaDataTree_ = opened->metaDataTree;
+    currentDataTrees_ = opened->dataTrees;
+    dataBranches_ = std::move(opened->dataBranches);
+    nEventsInCurrentFile_ = opened->nEvents;
+    fileIndexInCurrentFile_ = std::move(opened->fileIndex);
+    branchIDListsInCurrentFile_ = std::move(opened->branchIDLists);
+    ffVersion_ = opened->ffVersion;
+    branchInfos_ = std::move(branchInfos);
+    lastMixedProduct_ = lastMixedProduct;
+    if (branchIDListsInCurrentFile_) {
+      configureProductIDStreamer(branchIDListsInCurrentFile_.get());
+    }
+  }
+
+  // If this file was followed by another one the last time it was
+  // mixed, or is followed by one in the list given at construction,
+  // open and index that one in the background.
+  if (!previousFileName_.empty()) {
+    nextFileNames_[previousFileName_] = filename;
+  }
+  previousFileName_ = filename;
+  if (auto it = nextFileNames_.find(filename);
+      it != cend(nextFileNames_) && it->second != filename) {
+    nextFileName_ = it->second;
+    nextFile_ =
+      std::async(std::launch::async, &RootIOPolicy::openFile, nextFileName_);
+  }
 }
 
 art::EventAuxiliarySequence
 art::RootIOPolicy::generateEventAuxiliarySequence(
   EntryNumberSequence const& enseq)
 {
+  waitForPrefetch();
+  auto const entries = sortedEntries(enseq);
+  EventAuxiliarySequence auxiliaries;
+  auxiliaries.reserve(entries.size());
+  {
+    InputSourceMutexSentry sentry;
+    auto const eventTree = currentDataTrees_[InEvent];
+    auto auxBranch =
+      eventTree->GetBranch(BranchTypeToAuxiliaryBranchName(InEvent).c_str());
+    auto aux = std::make_unique<EventAuxiliary>();
+    auto pAux = aux.get();
+    auxBranch->SetAddress(&pAux);
+    for (auto const entry : entries) {
+      auto err = eventTree->LoadTree(entry);
+      if (err == -2) {
+        // FIXME: Throw an error here, taking care to disconnect the
+        // branch from the i/o buffer.
+        // FIXME: -2 means entry number too big.
+      }
+      // Note: Root will overwrite the old event auxiliary with the new
+      //       one.
+      input::getEntry(auxBranch, entry);
+      // Note: We are intentionally making a copy here of the fetched
+      //       event auxiliary!
+      auxiliaries.push_back(*pAux);
+    }
+    // Disconnect the branch from the i/o buffer.
+    auxBranch->SetAddress(nullptr);
+  }
   EventAuxiliarySequence result;
   result.reserve(enseq.size());
-  InputSourceMutexSentry sentry;
-  auto const eventTree = currentDataTrees_[InEvent];
-  auto auxBranch =
-    eventTree->GetBranch(BranchTypeToAuxiliaryBranchName(InEvent).c_str());
-  auto aux = std::make_unique<EventAuxiliary>();
-  auto pAux = aux.get();
-  auxBranch->SetAddress(&pAux);
   for (auto const entry : enseq) {
-    auto err = eventTree->LoadTree(entry);
-    if (err == -2) {
-      // FIXME: Throw an error here, taking care to disconnect the
-      // branch from the i/o buffer.
-      // FIXME: -2 means entry number too big.
-    }
-    // Note: Root will overwrite the old event auxiliary with the new
-    //       one.
-    input::getEntry(auxBranch, entry);
-    // Note: We are intentionally making a copy here of the fetched
-    //       event auxiliary!
-    result.push_back(*pAux);
-  }
-  // Disconnect the branch from the i/o buffer.
-  auxBranch->SetAddress(nullptr);
+    result.push_back(auxiliaries[indexOf(entries, entry)]);
+  }
   return result;
 }
 
@@ -168,8 +315,7 @@ art::SpecProdList
 art::RootIOPolicy::readFromFile(MixOpBase const& op,
                                 EntryNumberSequence const& seq)
 {
-  SpecProdList result;
-  result.reserve(seq.size());
+  waitForPrefetch();
   auto info = branchInfos_.find(op.incomingProductID());
   if (info == cend(branchInfos_)) {
     throw Exception(errors::LogicError)
@@ -184,25 +330,79 @@ art::RootIOPolicy::readFromFile(MixOpBase const& op,
   }
   // Make sure we don't have a ProductGetter set.
   configureRefCoreStreamer();
-  // Assume the sequence is ordered per
-  // MixHelper::generateEventSequence.
-  auto const b = seq.cbegin(), e = seq.cend();
-  for (auto i = b; i != e; ++i) {
-    auto fit = std::find(b, i, *i);
-    if (fit == i) {
-      // Need new product.
+  // Each distinct entry is read once; entries that are mixed more than
+  // once share the product.
+  auto const entries = sortedEntries(seq);
+  SpecProdList products;
+  products.reserve(entries.size());
+  {
+    // MT-FIXME
+    InputSourceMutexSentry sentry;
+    auto const branch = info->second.branch();
+    auto const tree = branch->GetTree();
+    for (auto const entry : entries) {
       auto ep = op.newIncomingWrappedProduct();
-      result.emplace_back(ep); // ep now owned by shared_ptr
-      // MT-FIXME
-      InputSourceMutexSentry sentry;
-      info->second.branch()->SetAddress(&ep);
-      input::getEntry(info->second.branch(), *i);
-    } else {
-      // Already have one: find and use.
-      auto pit = result.cbegin();
-      std::advance(pit, std::distance(b, fit));
-      result.emplace_back(*pit);
+      products.emplace_back(ep); // ep now owned by shared_ptr
+      tree->LoadTree(entry);
+      branch->SetAddress(&ep);
+      input::getEntry(branch, entry);
     }
   }
+  SpecProdList result;
+  result.reserve(seq.size());
+  for (auto const entry : seq) {
+    result.push_back(products[indexOf(entries, entry)]);
+  }
+  if (op.branchType() == InEvent &&
+      op.incomingProductID() == lastMixedProduct_) {
+    schedulePrefetch(entries);
+  }
   return result;
 }
+
+void
+art::RootIOPolicy::schedulePrefetch(EntryNumberSequence const& entries)
+{
+  // The next primary event can only be predicted if the secondary
+  // events are mixed sequentially: it will then mix the same number of
+  // entries that follow the ones just read.
+  if (entries.empty() ||
+      entries.back() - entries.front() + 1 !=
+        static_cast<EntryNumberSequence::value_type>(entries.size())) {
+    return;
+  }
+  auto const next = entries.back() + 1;
+  if (next >= static_cast<EntryNumberSequence::value_type>(
+                nEventsInCurrentFile_)) {
+    return;
+  }
+  // The file is read only by this policy, which waits for the prefetch
+  // before it touches the file again, and filling the cache reads raw
+  // baskets without any streamer.  The input-source lock is therefore
+  // not needed; what is read is bounded by the size of the cache.
+  auto const eventTree = currentDataTrees_[InEvent].get();
+  prefetch_ = std::async(std::launch::async, [this, eventTree, next] {
+    if (eventTree->LoadTree(next) < 0) {
+      return;
+    }
+    if (auto cache =
+          dynamic_cast<TTreeCache*>(currentFile_->GetCacheRead(eventTree))) {
+      cache->FillBuffer();
+    }
+  });
+}
+
+void
+art::RootIOPolicy::waitForPrefetch()
+{
+  if (!prefetch_.valid()) {
+    return;
+  }
+  // A failed prefetch is of no consequence: the entries are read again
+  // when they are mixed.
+  try {
+    prefetch_.get();
+  }
+  catch (...) {
+  }
+}
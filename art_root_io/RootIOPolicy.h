@@ -12,12 +12,31 @@
 #include "TFile.h"
 
 #include <array>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
 
 class TTree;
 
 namespace art {
 
   class RootIOPolicy : public MixIOPolicy {
+  public:
+    static constexpr Long64_t defaultTreeCacheSize{20 * 1024 * 1024};
+
+    RootIOPolicy();
+    // The successor of each of 'fileNames' (the first one for the last
+    // one) is pre-opened as soon as that file is opened, from the first
+    // pass through the files onward.  'treeCacheSize' is the size in
+    // bytes of the TTreeCache of the event tree, which holds only the
+    // mixed branches and bounds what is prefetched for the next primary
+    // event; 0 disables the cache and the prefetch.
+    explicit RootIOPolicy(std::vector<std::string> const& fileNames,
+                          Long64_t treeCacheSize = defaultTreeCacheSize);
+    ~RootIOPolicy();
+
+  private:
     std::size_t
     nEventsInFile() const override
     {
@@ -49,6 +68,30 @@ namespace art {
     SpecProdList readFromFile(MixOpBase const& mixOp,
                               EntryNumberSequence const& seq) override;
 
+    // Load the baskets of the mixed event branches for the entries
+    // expected to be mixed into the next primary event, on a background
+    // thread.
+    void schedulePrefetch(EntryNumberSequence const& entries);
+    void waitForPrefetch();
+
+    // A secondary file that has been opened and indexed, but not yet
+    // matched against the mix operations.
+    struct OpenedFile {
+      std::unique_ptr<TFile> file{};
+      cet::exempt_ptr<TTree> metaDataTree{nullptr};
+      std::array<cet::exempt_ptr<TTree>, art::BranchType::NumBranchTypes>
+        dataTrees{{nullptr}};
+      std::array<RootBranchInfoList, art::BranchType::NumBranchTypes>
+        dataBranches{{}};
+      std::size_t nEvents{};
+      FileFormatVersion ffVersion{};
+      FileIndex fileIndex{};
+      std::unique_ptr<BranchIDLists const> branchIDLists{nullptr};
+    };
+    static OpenedFile openFile(std::string const& fileName);
+    void discardNextFile();
+
+    Long64_t const treeCacheSize_{defaultTreeCacheSize};
     std::unique_ptr<TFile> currentFile_{};
     cet::exempt_ptr<TTree> currentMetaDataTree_{nullptr};
     std::array<cet::exempt_ptr<TTree>, art::BranchType::NumBranchTypes>
@@ -61,6 +104,19 @@ namespace art {
     EventIDIndex eventIDIndexInCurrentFile_{};
     std::unique_ptr<BranchIDLists const> branchIDListsInCurrentFile_{nullptr};
     std::map<ProductID, RootBranchInfo> branchInfos_{};
+    // The product read last for each primary event; reading it
+    // triggers the prefetch for the next one.
+    ProductID lastMixedProduct_{};
+    std::future<void> prefetch_{};
+    bool dictionariesChecked_{false};
+    // The file that followed each file the last time it was mixed, or
+    // that follows it in the list given at construction.  When a file
+    // is opened, its successor is opened in the background so that it
+    // is ready when the mixing helper rolls over to it.
+    std::map<std::string, std::string> nextFileNames_{};
+    std::string previousFileName_{};
+    std::string nextFileName_{};
+    std::future<OpenedFile> nextFile_{};
   };
 }
 #endif /* art_root_io_RootIOPolicy_h */
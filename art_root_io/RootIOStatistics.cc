@@ -0,0 +1,269 @@
+#include "art_root_io/RootIOStatistics.h"
+// vim: set sw=2 expandtab :
+
+#include "art/Framework/Services/Registry/ActivityRegistry.h"
+#include "canvas/Utilities/Exception.h"
+#include "cetlib/sqlite/Transaction.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "sqlite3.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <utility>
+
+namespace {
+
+  using art::RootIOStatistics;
+
+  struct Totals {
+    unsigned long long entries{};
+    unsigned long long compressedBytes{};
+    unsigned long long uncompressedBytes{};
+    std::chrono::nanoseconds time{};
+    unsigned long long cacheHits{};
+    unsigned long long cacheMisses{};
+    std::chrono::nanoseconds lockWait{};
+  };
+
+  Totals
+  totals(RootIOStatistics::TreeCounts const& tree)
+  {
+    Totals result;
+    for (auto const& b : tree.branches) {
+      result.entries += b.entries;
+      result.compressedBytes += b.compressedBytes;
+      result.uncompressedBytes += b.uncompressedBytes;
+      result.time += b.time;
+      result.cacheHits += b.cacheHits;
+      result.cacheMisses += b.cacheMisses;
+      result.lockWait += b.lockWait;
+    }
+    if (tree.compressedBytes) {
+      result.compressedBytes = *tree.compressedBytes;
+    }
+    return result;
+  }
+
+  double
+  seconds(std::chrono::nanoseconds const t)
+  {
+    return std::chrono::duration<double>{t}.count();
+  }
+
+  char const*
+  to_string(RootIOStatistics::Direction const d)
+  {
+    return d == RootIOStatistics::Direction::Read ? "read" : "write";
+  }
+
+  void
+  exec(sqlite3* db, std::string const& ddl)
+  {
+    char* errmsg{nullptr};
+    if (sqlite3_exec(db, ddl.c_str(), nullptr, nullptr, &errmsg) !=
+        SQLITE_OK) {
+      std::string const msg{errmsg != nullptr ? errmsg : ""};
+      sqlite3_free(errmsg);
+      throw art::Exception{art::errors::SQLExecutionError}
+        << "Error executing statement for RootIOStatistics.\n"
+        << "Statement: " << ddl << '\n'
+        << "SQLite error: " << msg << '\n';
+    }
+  }
+
+  class Statement {
+  public:
+    Statement(sqlite3* db, std::string const& ddl) : db_{db}
+    {
+      if (sqlite3_prepare_v2(db, ddl.c_str(), -1, &stmt_, nullptr) !=
+          SQLITE_OK) {
+        throw art::Exception{art::errors::SQLExecutionError}
+          << "Error in preparing statement for RootIOStatistics.\n"
+          << "Preparation statement: " << ddl << '\n'
+          << "SQLite error: " << sqlite3_errmsg(db) << '\n';
+      }
+    }
+    ~Statement() { sqlite3_finalize(stmt_); }
+
+    Statement(Statement const&) = delete;
+    Statement& operator=(Statement const&) = delete;
+
+    template <typename... Args>
+    void
+    insert(Args const&... args)
+    {
+      int i{};
+      (bind(++i, args), ...);
+      auto const rc = sqlite3_step(stmt_);
+      sqlite3_reset(stmt_);
+      if (rc != SQLITE_DONE) {
+        throw art::Exception{art::errors::SQLExecutionError}
+          << "Unexpected status from insertion (" << rc
+          << "): " << sqlite3_errmsg(db_) << '\n';
+      }
+    }
+
+  private:
+    void
+    bind(int const i, std::string const& s)
+    {
+      sqlite3_bind_text(stmt_, i, s.c_str(), s.size(), SQLITE_TRANSIENT);
+    }
+    void
+    bind(int const i, char const* s)
+    {
+      sqlite3_bind_text(stmt_, i, s, -1, SQLITE_TRANSIENT);
+    }
+    void
+    bind(int const i, unsigned long long const n)
+    {
+      sqlite3_bind_int64(stmt_, i, static_cast<sqlite3_int64>(n));
+    }
+    void
+    bind(int const i, double const x)
+    {
+      sqlite3_bind_double(stmt_, i, x);
+    }
+    void
+    bind(int const i, std::optional<double> const& x)
+    {
+      if (x) {
+        bind(i, *x);
+      } else {
+        sqlite3_bind_null(stmt_, i);
+      }
+    }
+
+    sqlite3* db_;
+    sqlite3_stmt* stmt_{nullptr};
+  };
+
+} // unnamed namespace
+
+namespace art {
+
+  RootIOStatistics::RootIOStatistics(Parameters const& config,
+                                     ActivityRegistry& r)
+    : dbFileName_{config().dbOutput().filename()}
+    , overwrite_{config().dbOutput().overwrite()}
+    , printSummary_{config().printSummary()}
+  {
+    r.sPostEndJob.watch([this] {
+      if (printSummary_) {
+        logSummary_();
+      }
+      if (!dbFileName_.empty()) {
+        writeDB_();
+      }
+    });
+  }
+
+  void
+  RootIOStatistics::record(TreeCounts counts)
+  {
+    std::lock_guard sentry{mutex_};
+    trees_.push_back(std::move(counts));
+  }
+
+  void
+  RootIOStatistics::writeDB_() const
+  {
+    std::lock_guard sentry{mutex_};
+    sqlite3* db{nullptr};
+    if (sqlite3_open_v2(dbFileName_.c_str(),
+                        &db,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                        nullptr) != SQLITE_OK) {
+      std::string const msg{db != nullptr ? sqlite3_errmsg(db) :
+                                            "out of memory"};
+      sqlite3_close(db);
+      throw Exception{errors::SQLExecutionError}
+        << "RootIOStatistics could not open " << dbFileName_ << ".\n"
+        << "SQLite error: " << msg << '\n';
+    }
+    std::unique_ptr<sqlite3, decltype(&sqlite3_close)> const closer{
+      db, &sqlite3_close};
+    if (overwrite_) {
+      exec(db, "DROP TABLE IF EXISTS BranchIO; DROP TABLE IF EXISTS TreeIO;");
+    }
+    exec(db,
+         "CREATE TABLE IF NOT EXISTS BranchIO(File TEXT, Tree TEXT, "
+         "Branch TEXT, Direction TEXT, Entries INTEGER, "
+         "CompressedBytes INTEGER, UncompressedBytes INTEGER, Time NUMERIC, "
+         "CacheHits INTEGER, CacheMisses INTEGER, LockWait NUMERIC);"
+         "CREATE TABLE IF NOT EXISTS TreeIO(File TEXT, Tree TEXT, "
+         "Direction TEXT, Entries INTEGER, CompressedBytes INTEGER, "
+         "UncompressedBytes INTEGER, DecompressTime NUMERIC, "
+         "StreamTime NUMERIC, CacheHits INTEGER, CacheMisses INTEGER, "
+         "LockWait NUMERIC);");
+    {
+      Statement branchIO{
+        db, "INSERT INTO BranchIO VALUES(?,?,?,?,?,?,?,?,?,?,?);"};
+      Statement treeIO{db,
+                       "INSERT INTO TreeIO VALUES(?,?,?,?,?,?,?,?,?,?,?);"};
+      cet::sqlite::Transaction txn{db};
+      for (auto const& tree : trees_) {
+        auto const direction = to_string(tree.direction);
+        for (auto const& b : tree.branches) {
+          branchIO.insert(tree.file,
+                          tree.tree,
+                          b.branch,
+                          direction,
+                          b.entries,
+                          b.compressedBytes,
+                          b.uncompressedBytes,
+                          seconds(b.time),
+                          b.cacheHits,
+                          b.cacheMisses,
+                          seconds(b.lockWait));
+        }
+        auto const t = totals(tree);
+        std::optional<double> decompressTime;
+        auto streamTime = t.time;
+        if (tree.decompressTime) {
+          decompressTime = seconds(*tree.decompressTime);
+          streamTime = std::max(t.time - *tree.decompressTime,
+                                std::chrono::nanoseconds::zero());
+        }
+        treeIO.insert(tree.file,
+                      tree.tree,
+                      direction,
+                      t.entries,
+                      t.compressedBytes,
+                      t.uncompressedBytes,
+                      decompressTime,
+                      seconds(streamTime),
+                      t.cacheHits,
+                      t.cacheMisses,
+                      seconds(t.lockWait));
+      }
+      txn.commit();
+    }
+  }
+
+  void
+  RootIOStatistics::logSummary_() const
+  {
+    std::lock_guard sentry{mutex_};
+    if (trees_.empty()) {
+      return;
+    }
+    mf::LogAbsolute log{"RootIOStatistics"};
+    log << "RootIOStatistics summary\n"
+        << "  " << std::setw(6) << "Dir" << std::setw(14) << "Compr. [MB]"
+        << std::setw(14) << "Uncompr. [MB]" << std::setw(10) << "Time [s]"
+        << std::setw(14) << "Lock wait [s]"
+        << "  Tree (File)\n";
+    for (auto const& tree : trees_) {
+      auto const t = totals(tree);
+      log << "  " << std::setw(6) << to_string(tree.direction)
+          << std::setw(14) << t.compressedBytes / 1.e6 << std::setw(14)
+          << t.uncompressedBytes / 1.e6 << std::setw(10) << seconds(t.time)
+          << std::setw(14) << seconds(t.lockWait) << "  " << tree.tree << " ("
+          << tree.file << ")\n";
+    }
+  }
+
+} // namespace art
@@ -0,0 +1,105 @@
+#ifndef art_root_io_RootIOStatistics_h
+#define art_root_io_RootIOStatistics_h
+// vim: set sw=2 expandtab :
+
+// ======================================================================
+// RootIOStatistics
+//
+// Collects per-branch and per-tree I/O statistics from RootInput and
+// RootOutput, and writes them at the end of the job to an SQLite
+// database (tables 'BranchIO' and 'TreeIO'), in the manner of art's
+// TimeTracker service.  The statistics are gathered only if the
+// service is configured:
+//
+//   services.RootIOStatistics: {
+//     dbOutput: { filename: "io.db" overwrite: true }
+//   }
+//
+// For reads, the time of a branch covers reading, decompressing and
+// streaming its entries.  The decompression time and the compressed
+// bytes read are known per tree only (from TTreePerfStats, for the
+// Events tree); the compressed bytes of a branch are estimated from
+// its compression factor.  For writes, the time of a branch covers
+// streaming its entries and, unless baskets are compressed in
+// parallel, compressing and writing full baskets.
+// ======================================================================
+
+#include "art/Framework/Services/Registry/ServiceDeclarationMacros.h"
+#include "art/Framework/Services/Registry/ServiceTable.h"
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/Name.h"
+#include "fhiclcpp/types/Table.h"
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace art {
+
+  class ActivityRegistry;
+
+  class RootIOStatistics {
+  public:
+    struct Config {
+      struct DBOutput {
+        fhicl::Atom<std::string> filename{fhicl::Name("filename"), ""};
+        fhicl::Atom<bool> overwrite{fhicl::Name("overwrite"), false};
+      };
+      fhicl::Table<DBOutput> dbOutput{fhicl::Name("dbOutput")};
+      fhicl::Atom<bool> printSummary{fhicl::Name("printSummary"), true};
+    };
+    using Parameters = ServiceTable<Config>;
+
+    enum class Direction { Read, Write };
+
+    struct BranchCounts {
+      std::string branch;
+      unsigned long long entries{};
+      unsigned long long compressedBytes{};
+      unsigned long long uncompressedBytes{};
+      std::chrono::nanoseconds time{};
+      unsigned long long cacheHits{};
+      unsigned long long cacheMisses{};
+      std::chrono::nanoseconds lockWait{};
+    };
+
+    struct TreeCounts {
+      std::string file;
+      std::string tree;
+      Direction direction;
+      std::vector<BranchCounts> branches{};
+      // Measured for the whole tree, if available.  Otherwise, the
+      // compressed bytes are the sum over the branches.
+      std::optional<unsigned long long> compressedBytes{};
+      std::optional<std::chrono::nanoseconds> decompressTime{};
+    };
+
+    RootIOStatistics(Parameters const&, ActivityRegistry&);
+
+    RootIOStatistics(RootIOStatistics const&) = delete;
+    RootIOStatistics& operator=(RootIOStatistics const&) = delete;
+
+    void record(TreeCounts counts);
+
+  private:
+    void writeDB_() const;
+    void logSummary_() const;
+
+    std::string const dbFileName_;
+    bool const overwrite_;
+    bool const printSummary_;
+    mutable std::mutex mutex_{};
+    std::vector<TreeCounts> trees_{};
+  };
+
+} // namespace art
+
+DECLARE_ART_SERVICE(art::RootIOStatistics, SHARED)
+
+#endif /* art_root_io_RootIOStatistics_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,6 @@
+#include "art/Framework/Services/Registry/ServiceDefinitionMacros.h"
+#include "art_root_io/RootIOStatistics.h"
+
+// vim: set sw=2 expandtab :
+
+DEFINE_ART_SERVICE(art::RootIOStatistics)
@@ -97,6 +97,11 @@ RootInput::doEndJob()
 void
 RootInput::closeFile()
 {
+  // A seek to an event of another file has already closed the previous
+  // file and opened the one that holds the event.
+  if (accessState_.state() == AccessState::SEEKING_FILE) {
+    return;
+  }
   primaryFileSequence_.closeFile_();
 }
 
@@ -2,6 +2,7 @@
 // vim: set sw=2 expandtab :
 
 #include "art/Framework/Core/GroupSelector.h"
+#include "art/Framework/Core/InputSourceMutex.h"
 #include "art/Framework/Core/ProcessingLimits.h"
 #include "art/Framework/Core/UpdateOutputCallbacks.h"
 #include "art/Framework/Principal/ClosedRangeSetHandler.h"
@@ -21,7 +22,10 @@
 #include "art_root_io/RootDB/TKeyVFSOpenPolicy.h"
 #include "art_root_io/RootDelayedReader.h"
 #include "art_root_io/RootFileBlock.h"
+#include "art_root_io/RootIOStatistics.h"
 #include "art_root_io/checkDictionaries.h"
+#include "art_root_io/detail/RangeSetResolver.h"
+#include "art_root_io/detail/dropBranch.h"
 #include "art_root_io/detail/getObjectRequireDict.h"
 #include "art_root_io/detail/readFileIndex.h"
 #include "art_root_io/detail/readMetadata.h"
@@ -47,10 +51,16 @@
 
 #include "TBranch.h"
 #include "TFile.h"
-#include "TLeaf.h"
 #include "TTree.h"
+#include "TTreeCache.h"
+#include "TTreeCacheUnzip.h"
+#include "TTreePerfStats.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <iomanip>
+#include <set>
 #include <string>
 #include <utility>
 
@@ -58,12 +68,6 @@
 
 namespace {
 
-  sqlite3*
-  db_or_nullptr(std::unique_ptr<cet::sqlite::Connection> const& db)
-  {
-    return db.get() == nullptr ? nullptr : static_cast<sqlite3*>(*db);
-  }
-
   bool
   have_table(sqlite3* db, std::string const& table, std::string const& filename)
   {
@@ -183,35 +187,10 @@ namespace art {
   }
 
   void
-  RootInputFile::RootInputTree::dropBranch(std::string const& branchName)
+  RootInputFile::RootInputTree::dropBranches(
+    std::vector<std::string> const& branchNames)
   {
-    TBranch* branch = tree_->GetBranch(branchName.c_str());
-    if (branch == nullptr) {
-      return;
-    }
-    TObjArray* leaves = tree_->GetListOfLeaves();
-    if (leaves == nullptr) {
-      return;
-    }
-    int entries = leaves->GetEntries();
-    for (int i = 0; i < entries; ++i) {
-      TLeaf* leaf = reinterpret_cast<TLeaf*>((*leaves)[i]);
-      if (leaf == nullptr) {
-        continue;
-      }
-      TBranch* br = leaf->GetBranch();
-      if (br == nullptr) {
-        continue;
-      }
-      if (br->GetMother() == branch) {
-        leaves->Remove(leaf);
-      }
-    }
-    leaves->Compress();
-    tree_->GetListOfBranches()->Remove(branch);
-    tree_->GetListOfBranches()->Compress();
-    delete branch;
-    branch = nullptr;
+    detail::dropBranches(tree_, branchNames);
   }
 
   namespace {
@@ -247,6 +226,11 @@ namespace art {
     bool const dropDescendants,
     bool const readIncomingParameterSets,
     UpdateOutputCallbacks& outputCallbacks,
+    bool const readAhead,
+    bool const parallelUnzip,
+    bool const reportReadStatistics,
+    unsigned const pruneUnreadProductsAfter,
+    unsigned const reorderWindow,
     secondary_reader_t openSecondaryFile,
     std::shared_ptr<DuplicateChecker> duplicateChecker)
     : fileName_{fileName}
@@ -267,6 +251,9 @@ namespace art {
     , readFromSecondaryFile_{openSecondaryFile}
     , duplicateChecker_{duplicateChecker}
     , saveMemoryObjectThreshold_{saveMemoryObjectThreshold}
+    , reportReadStatistics_{reportReadStatistics}
+    , pruneUnreadProductsAfter_{pruneUnreadProductsAfter}
+    , reorderWindow_{noEventSort ? 0u : reorderWindow}
   {
     if (treeMaxVirtualSize >= 0) {
       eventTree().tree()->SetMaxVirtualSize(
@@ -290,6 +277,11 @@ namespace art {
       }
       resultsTree().tree()->SetCacheSize(static_cast<Long64_t>(treeCacheSize));
     }
+    if (ServiceRegistry::isAvailable<RootIOStatistics>()) {
+      ioStatistics_ = ServiceHandle<RootIOStatistics>{}.get();
+      perfStats_ = std::make_unique<TTreePerfStats>("RootIOStatistics",
+                                                    eventTree().tree());
+    }
     // Retrieve the metadata tree.
     auto metaDataTree =
       filePtr_->Get<TTree>(rootNames::metaDataTreeName().c_str());
@@ -353,6 +345,8 @@ namespace art {
     if (fileFormatVersion_.value_ >= 5) {
       sqliteDB_ = ServiceHandle<DatabaseConnection>()->get<TKeyVFSOpenPolicy>(
         "RootFileDB", filePtr_.get());
+      rangeSetResolver_ = std::make_unique<detail::RangeSetResolver>(
+        *sqliteDB_, fileName_, compactSubRunRanges_);
       if (readIncomingParameterSets &&
           have_table(*sqliteDB_, "ParameterSets", fileName_)) {
         fhicl::ParameterSetRegistry::importFrom(*sqliteDB_);
@@ -434,12 +428,17 @@ namespace art {
     };
     for_each_branch_type(set_validity_then_add_branch);
 
+    if (readAhead) {
+      configureReadAhead(treeCacheSize, parallelUnzip);
+    }
+
     // Invoke output callbacks with adjusted BranchDescription
     // validity values.
     outputCallbacks.invoke(presentProducts_);
 
     // Determine if this file is fast clonable.
     fastClonable_ = setIfFastClonable();
+    runsAndSubRunsFastClonable_ = setIfRunsAndSubRunsFastClonable();
 
     // Check if dictionaries exist for the auxiliary objects
     root::DictionaryChecker checker{};
@@ -536,9 +535,10 @@ namespace art {
   RootInputFile::resolveInfo(BranchType const bt,
                              unsigned const range_set_id) const
   {
-    assert(sqliteDB_);
-    return detail::resolveRangeSetInfo(
-      *sqliteDB_, fileName_, bt, range_set_id, compactSubRunRanges_);
+    assert(rangeSetResolver_);
+    // The RootFileDB may be paged through the input file itself.
+    InputSourceMutexSentry sentry;
+    return rangeSetResolver_->info(bt, range_set_id);
   }
 
   template <typename Aux>
@@ -701,6 +701,40 @@ namespace art {
     return enabled;
   }
 
+  FastCloningEnabled
+  RootInputFile::setIfRunsAndSubRunsFastClonable() const
+  {
+    // The output module writes one run or subrun entry each time it
+    // is given a run or subrun.  The entries of the input file can
+    // therefore be cloned only if each run and subrun is read from a
+    // single entry, in entry order, and with all of its events.
+    auto enabled = fastClonable_;
+    if (fileFormatVersion_.value_ < 9 || !rangeSetResolver_) {
+      enabled.disable("The input file does not record RangeSets.");
+    }
+    for (auto const type : {FileIndex::kRun, FileIndex::kSubRun}) {
+      auto const name = type == FileIndex::kRun ? "run" : "subrun";
+      FileIndex::const_iterator previous{fiEnd_};
+      for (auto it = fiBegin_; it != fiEnd_; ++it) {
+        if (it->getEntryType() != type) {
+          continue;
+        }
+        if (previous != fiEnd_ && previous->eventID == it->eventID) {
+          enabled.disable(std::string{"A "} + name +
+                          " is stored in more than one entry.");
+          break;
+        }
+        if (previous != fiEnd_ && previous->entry > it->entry) {
+          enabled.disable(std::string{"The "} + name +
+                          "s are not in entry order.");
+          break;
+        }
+        previous = it;
+      }
+    }
+    return enabled;
+  }
+
   std::unique_ptr<FileBlock>
   RootInputFile::createFileBlock()
   {
@@ -709,7 +743,11 @@ namespace art {
       fileName_,
       readResults(),
       cet::make_exempt_ptr(eventTree().tree()),
-      fastClonable_);
+      fastClonable_,
+      cet::make_exempt_ptr(subRunTree().tree()),
+      cet::make_exempt_ptr(runTree().tree()),
+      cet::make_exempt_ptr(rangeSetResolver_.get()),
+      runsAndSubRunsFastClonable_);
   }
 
   FileIndex::EntryType
@@ -811,9 +849,236 @@ namespace art {
   void
   RootInputFile::close()
   {
+    InputSourceMutexSentry sentry;
+    reorderBuffer_.clear();
+    if (reportReadStatistics_) {
+      reportReadStatistics();
+    }
+    if (ioStatistics_) {
+      recordIOStatistics();
+    }
     filePtr_->Close();
   }
 
+  void
+  RootInputFile::configureReadAhead(unsigned int const treeCacheSize,
+                                    bool const parallelUnzip)
+  {
+    TTree* tree = eventTree().tree();
+    // Parallel unzipping must be requested before the cache is
+    // created.  The baskets are then decompressed by ROOT's
+    // implicit-MT thread pool.
+    if (parallelUnzip) {
+      tree->SetParallelUnzip(kTRUE);
+    }
+    // A cache size of 0 would disable the cache; use ROOT's default
+    // size instead.
+    tree->SetCacheSize(treeCacheSize == 0u ?
+                         -1 :
+                         static_cast<Long64_t>(treeCacheSize));
+
+    // Register exactly the branches that survived dropOnInput; there
+    // is no need for the cache to learn them from the first reads.
+    tree->AddBranchToCache(eventTree().auxBranch(), kTRUE);
+    for (auto const& info : eventTree().branches() | ranges::views::values) {
+      if (info.productBranch_ != nullptr) {
+        tree->AddBranchToCache(info.productBranch_, kTRUE);
+      }
+    }
+    tree->StopCacheLearningPhase();
+    tree->SetClusterPrefetch(true);
+
+    // Restrict the read-ahead to the entries that the FileIndex says
+    // will be read.
+    EntryNumber first{FileIndex::Element::invalid};
+    EntryNumber last{FileIndex::Element::invalid};
+    for (auto const& element : fileIndex_) {
+      if (element.getEntryType() != FileIndex::kEvent ||
+          element.eventID < origEventID_) {
+        continue;
+      }
+      if (first == FileIndex::Element::invalid || element.entry < first) {
+        first = element.entry;
+      }
+      last = std::max(last, element.entry);
+    }
+    if (first != FileIndex::Element::invalid) {
+      tree->SetCacheEntryRange(first, last + 1);
+    }
+    if (!noEventSort_ && !fileIndex_.allEventsInEntryOrder()) {
+      mf::LogInfo("RootInputFile")
+        << "The events of input file " << fileName_
+        << " are not stored in EventID order.\n"
+        << "Read-ahead is less effective unless 'noEventSort' is 'true'.\n";
+    }
+  }
+
+  bool
+  RootInputFile::timeReads() const
+  {
+    // Only reported statistics are worth the clock reads.
+    return reportReadStatistics_ || ioStatistics_ != nullptr;
+  }
+
+  void
+  RootInputFile::reportReadStatistics() const
+  {
+    TTree* tree = eventTree().tree();
+    mf::LogInfo log{"RootInputFile"};
+    log << "Event-tree read statistics for input file " << fileName_ << '\n';
+    if (auto cache =
+          dynamic_cast<TTreeCache*>(filePtr_->GetCacheRead(tree))) {
+      log << "  TTreeCache efficiency: " << cache->GetEfficiency()
+          << " (relative: " << cache->GetEfficiencyRel() << ")\n";
+      if (auto unzip = dynamic_cast<TTreeCacheUnzip*>(cache)) {
+        log << "  Parallel unzip: " << unzip->GetNUnzip()
+            << " baskets unzipped in the background, " << unzip->GetNFound()
+            << " found and " << unzip->GetNMissed()
+            << " missed by the reads\n";
+      }
+    }
+    log << "  " << std::setw(10) << "Reads" << std::setw(12) << "Hit rate"
+        << std::setw(14) << "Stall [ms]"
+        << "  Branch\n";
+    for (auto const& info : eventTree().branches() | ranges::views::values) {
+      auto const& stats = info.readStats_;
+      if (stats.reads == 0ul) {
+        continue;
+      }
+      using namespace std::chrono;
+      auto const hitRate = static_cast<double>(stats.cacheHits) / stats.reads;
+      log << "  " << std::setw(10) << stats.reads << std::setw(12)
+          << hitRate << std::setw(14)
+          << duration<double, std::milli>{stats.stallTime}.count() << "  "
+          << info.branchDescription_.branchName() << '\n';
+    }
+  }
+
+  void
+  RootInputFile::fillReorderBuffer()
+  {
+    // The events are emitted in FileIndex (EventID) order, which may
+    // jump around the Events tree.  The next reorderWindow_ events are
+    // therefore read ahead in entry order, together with the products
+    // that have been read from this file so far, and are handed out
+    // from the buffer in FileIndex order.  Events left in the buffer
+    // (e.g. after a seek) are discarded.
+    reorderBuffer_.clear();
+    std::vector<std::pair<EntryNumber, FileIndex::const_iterator>> window;
+    for (auto it = fiIter_; it != fiEnd_ && window.size() < reorderWindow_;
+         ++it) {
+      if (it->getEntryType() == FileIndex::kEvent) {
+        window.emplace_back(it->entry, it);
+      }
+    }
+    std::sort(window.begin(), window.end(), [](auto const& a, auto const& b) {
+      return a.first < b.first;
+    });
+
+    std::vector<ProductID> readProducts;
+    for (auto const& [pid, info] : eventTree().branches()) {
+      if (info.readStats_.reads != 0ul && info.active_) {
+        readProducts.push_back(pid);
+      }
+    }
+
+    auto const current = fiIter_;
+    for (auto const& [entry, it] : window) {
+      fiIter_ = it;
+      auto ep = readEventWithID(it->eventID);
+      for (auto const pid : readProducts) {
+        ep->getForOutput(pid, true);
+      }
+      reorderBuffer_.emplace(entry, std::move(ep));
+    }
+    fiIter_ = current;
+  }
+
+  void
+  RootInputFile::pruneUnreadProducts()
+  {
+    // Products requested after this point are reactivated by the
+    // delayed reader.
+    std::size_t nPruned{};
+    InputSourceMutexSentry sentry;
+    for (auto const& info : eventTree().branches() | ranges::views::values) {
+      if (info.productBranch_ != nullptr && info.readStats_.reads == 0ul) {
+        info.setActive(false);
+        ++nPruned;
+      }
+    }
+    mf::LogInfo("RootInputFile")
+      << "Deactivated " << nPruned << " of " << eventTree().branches().size()
+      << " event-product branches of input file " << fileName_
+      << " that were not read in its first " << pruneUnreadProductsAfter_
+      << " events processed.\n";
+  }
+
+  void
+  RootInputFile::readActiveProducts(EventPrincipal& ep) const
+  {
+    // Reading all products, as EventPrincipal::readImmediate does, would
+    // reactivate the pruned branches.
+    std::vector<ProductID> active;
+    {
+      InputSourceMutexSentry sentry;
+      for (auto const& [pid, info] : eventTree().branches()) {
+        if (info.productBranch_ != nullptr && info.active_) {
+          active.push_back(pid);
+        }
+      }
+    }
+    for (auto const pid : active) {
+      ep.getForOutput(pid, true);
+    }
+  }
+
+  void
+  RootInputFile::recordIOStatistics()
+  {
+    auto record_tree = [this](BranchType const bt) {
+      auto const& tree = *treePointers_[bt];
+      if (!tree.isValid()) {
+        return;
+      }
+      RootIOStatistics::TreeCounts counts{
+        fileName_, tree.tree()->GetName(), RootIOStatistics::Direction::Read};
+      for (auto const& info : tree.branches() | ranges::views::values) {
+        auto const& stats = info.readStats_;
+        if (stats.reads == 0ul) {
+          continue;
+        }
+        // ROOT does not attribute the compressed bytes read to
+        // branches; estimate them from the compression factor.
+        auto const* br = info.productBranch_;
+        auto const totBytes = br->GetTotBytes("*");
+        auto const compressed =
+          totBytes > 0 ? static_cast<unsigned long long>(
+                           static_cast<double>(stats.bytes) *
+                           br->GetZipBytes("*") / totBytes) :
+                         stats.bytes;
+        counts.branches.push_back({info.branchDescription_.branchName(),
+                                   stats.reads,
+                                   compressed,
+                                   stats.bytes,
+                                   stats.stallTime,
+                                   stats.cacheHits,
+                                   stats.reads - stats.cacheHits,
+                                   stats.lockWait});
+      }
+      if (bt == InEvent && perfStats_) {
+        perfStats_->Finish();
+        counts.compressedBytes = perfStats_->GetBytesRead();
+        counts.decompressTime =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>{perfStats_->GetUnzipTime()});
+        tree.tree()->SetPerfStats(nullptr);
+      }
+      ioStatistics_->record(std::move(counts));
+    };
+    for_each_branch_type(record_tree);
+  }
+
   void
   RootInputFile::fillHistory(EntryNumber const entry, History& history)
   {
@@ -873,7 +1138,16 @@ namespace art {
     assert(fiIter_->getEntryType() == FileIndex::kEvent);
     assert(fiIter_->eventID.runID().isValid());
 
-    auto ep = readEventWithID(fiIter_->eventID);
+    std::unique_ptr<EventPrincipal> ep;
+    if (reorderWindow_ > 1u) {
+      if (reorderBuffer_.count(fiIter_->entry) == 0u) {
+        fillReorderBuffer();
+      }
+      auto node = reorderBuffer_.extract(fiIter_->entry);
+      ep = std::move(node.mapped());
+    } else {
+      ep = readEventWithID(fiIter_->eventID);
+    }
     assert(ep);
     assert(ep->run() == fiIter_->eventID.run());
     assert(ep->eventID().subRunID() == fiIter_->eventID.subRunID());
@@ -892,6 +1166,14 @@ namespace art {
       return nullptr;
     }
 
+    // Only completed events count: those still in flight on other
+    // schedules may yet read products.
+    if (pruneUnreadProductsAfter_ != 0u && !pruned_ &&
+        eventsCompleted_ >= pruneUnreadProductsAfter_) {
+      pruneUnreadProducts();
+      pruned_ = true;
+    }
+
     auto const [entryNumbers, lastInSubRun] = getEntryNumbers(InEvent);
     assert(size(entryNumbers) == 1ull);
 
@@ -922,10 +1204,20 @@ namespace art {
                                           branchIDLists_.get(),
                                           InEvent,
                                           event_aux.eventID(),
-                                          compactSubRunRanges_),
+                                          timeReads(),
+                                          ioStatistics_ != nullptr,
+                                          pruneUnreadProductsAfter_ != 0u ?
+                                            &eventsCompleted_ :
+                                            nullptr),
       lastInSubRun);
+    // Until the unread branches are pruned, the products are read on
+    // demand, so that the unread ones are known.
     if (!delayedReadEventProducts_) {
-      ep->readImmediate();
+      if (pruneUnreadProductsAfter_ == 0u) {
+        ep->readImmediate();
+      } else if (pruned_) {
+        readActiveProducts(*ep);
+      }
     }
     return ep;
   }
@@ -968,7 +1260,7 @@ namespace art {
       processConfiguration_,
       &presentProducts_.get(InRun),
       std::make_unique<RootDelayedReader>(fileFormatVersion_,
-                                          db_or_nullptr(sqliteDB_),
+                                          rangeSetResolver_.get(),
                                           entryNumbers,
                                           &runTree().branches(),
                                           runTree().productProvenanceBranch(),
@@ -977,7 +1269,8 @@ namespace art {
                                           nullptr,
                                           InRun,
                                           fiIter_->eventID,
-                                          compactSubRunRanges_));
+                                          timeReads(),
+                                          ioStatistics_ != nullptr));
     if (!delayedReadRunProducts_) {
       rp->readImmediate();
     }
@@ -1026,7 +1319,7 @@ namespace art {
       &presentProducts_.get(InSubRun),
       std::make_unique<RootDelayedReader>(
         fileFormatVersion_,
-        db_or_nullptr(sqliteDB_),
+        rangeSetResolver_.get(),
         entryNumbers,
         &subRunTree().branches(),
         subRunTree().productProvenanceBranch(),
@@ -1035,7 +1328,8 @@ namespace art {
         nullptr,
         InSubRun,
         fiIter_->eventID,
-        compactSubRunRanges_));
+        timeReads(),
+        ioStatistics_ != nullptr));
     if (!delayedReadSubRunProducts_) {
       srp->readImmediate();
     }
@@ -1154,8 +1448,11 @@ namespace art {
           }
         }
 
-        // On this pass, actually drop the branches.
+        // On this pass, actually drop the branches.  They are removed
+        // from the tree all at once, which is much faster for wide
+        // trees than removing them one at a time.
         auto branchesToDropEnd = branchesToDrop.cend();
+        std::vector<std::string> branchNames;
         for (auto I = prodList.begin(), E = prodList.end(); I != E;) {
           auto const& bd = I->second;
           bool drop = branchesToDrop.find(bd.productID()) != branchesToDropEnd;
@@ -1171,10 +1468,11 @@ namespace art {
               << "' because it is dependent on a branch\n"
               << "that was explicitly dropped.\n";
           }
-          treePointers_[bt]->dropBranch(bd.branchName());
+          branchNames.push_back(bd.branchName());
           auto icopy = I++;
           prodList.erase(icopy);
         }
+        treePointers_[bt]->dropBranches(branchNames);
       };
     for_each_branch_type(dropOnInputForBranchType);
   }
@@ -1203,7 +1501,8 @@ namespace art {
         nullptr,
         InResults,
         EventID{},
-        compactSubRunRanges_));
+        timeReads(),
+        ioStatistics_ != nullptr));
   }
 
 } // namespace art
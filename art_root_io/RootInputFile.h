@@ -25,18 +25,25 @@
 #include "cetlib/sqlite/Connection.h"
 
 #include <array>
+#include <atomic>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 class TFile;
 class TTree;
 class TBranch;
+class TTreePerfStats;
 
 namespace art {
   class BranchChildren;
   class DuplicateChecker;
   class GroupSelectorRules;
+  class RootIOStatistics;
   namespace detail {
+    class RangeSetResolver;
     struct RangeSetInfo;
   }
 
@@ -62,7 +69,7 @@ namespace art {
       TBranch* productProvenanceBranch() const;
       BranchMap const& branches() const;
       void addBranch(BranchDescription const&);
-      void dropBranch(std::string const& branchName);
+      void dropBranches(std::vector<std::string> const& branchNames);
 
     private:
       TTree* tree_{nullptr};
@@ -75,6 +82,7 @@ namespace art {
 
     using RootInputTreePtrArray =
       std::array<std::unique_ptr<RootInputTree>, NumBranchTypes>;
+
     using EntryNumber = RootInputTree::EntryNumber;
     using EntryNumbers = RootInputTree::EntryNumbers;
 
@@ -102,6 +110,11 @@ namespace art {
                   bool dropDescendantsOfDroppedProducts,
                   bool readIncomingParameterSets,
                   UpdateOutputCallbacks& outputCallbacks,
+                  bool readAhead = false,
+                  bool parallelUnzip = false,
+                  bool reportReadStatistics = false,
+                  unsigned pruneUnreadProductsAfter = 0u,
+                  unsigned reorderWindow = 0u,
                   secondary_reader_t openSecondaryFile = {},
                   std::shared_ptr<DuplicateChecker> duplicateChecker = nullptr);
 
@@ -153,6 +166,7 @@ namespace art {
     RootInputTree& runTree();
     RootInputTree& resultsTree();
     FastCloningEnabled setIfFastClonable() const;
+    FastCloningEnabled setIfRunsAndSubRunsFastClonable() const;
     void validateFile();
     void fillHistory(EntryNumber entry, History&);
 
@@ -175,6 +189,13 @@ namespace art {
                      ProductTables& tables);
     void readParentageTree(unsigned int treeCacheSize);
     void readEventHistoryTree(unsigned int treeCacheSize);
+    void configureReadAhead(unsigned int treeCacheSize, bool parallelUnzip);
+    void reportReadStatistics() const;
+    void recordIOStatistics();
+    bool timeReads() const;
+    void pruneUnreadProducts();
+    void readActiveProducts(EventPrincipal& ep) const;
+    void fillReorderBuffer();
     void initializeDuplicateChecker();
     std::pair<EntryNumbers, bool> getEntryNumbers(BranchType);
 
@@ -183,6 +204,9 @@ namespace art {
     std::unique_ptr<TFile> filePtr_;
     // Start with invalid connection.
     std::unique_ptr<cet::sqlite::Connection> sqliteDB_{nullptr};
+    // Declared after sqliteDB_ so that its prepared statements are
+    // finalized before the connection is closed.
+    std::unique_ptr<detail::RangeSetResolver> rangeSetResolver_{nullptr};
     EventID origEventID_;
     EventNumber_t eventsToSkip_;
     bool const compactSubRunRanges_;
@@ -202,6 +226,7 @@ namespace art {
     FileIndex::const_iterator fiEnd_{fileIndex_.end()};
     FileIndex::const_iterator fiIter_{fiBegin_};
     FastCloningEnabled fastClonable_{};
+    FastCloningEnabled runsAndSubRunsFastClonable_{};
     ProductTables presentProducts_{ProductTables::invalid()};
     std::unique_ptr<BranchIDLists> branchIDLists_{};
     TTree* eventHistoryTree_{nullptr};
@@ -215,6 +240,21 @@ namespace art {
     std::unique_ptr<RangeSetHandler> subRunRangeSetHandler_{nullptr};
     std::unique_ptr<RangeSetHandler> runRangeSetHandler_{nullptr};
     int64_t saveMemoryObjectThreshold_;
+    bool const reportReadStatistics_;
+    // Event-product branches not read by the first
+    // pruneUnreadProductsAfter_ events of the file to be processed are
+    // deactivated.  The events are counted as their principals, and
+    // with them their delayed readers, are destroyed.
+    unsigned const pruneUnreadProductsAfter_;
+    std::atomic<std::size_t> eventsCompleted_{};
+    bool pruned_{false};
+    // The events of the next reorderWindow_ FileIndex positions, read
+    // in entry order and keyed by entry; see readEvent().
+    unsigned const reorderWindow_;
+    std::map<EntryNumber, std::unique_ptr<EventPrincipal>> reorderBuffer_{};
+    // Set only if the RootIOStatistics service is configured.
+    RootIOStatistics* ioStatistics_{nullptr};
+    std::unique_ptr<TTreePerfStats> perfStats_{};
   };
 
   extern template bool RootInputFile::setEntry<RunID>(RunID const& id, bool);
@@ -14,9 +14,13 @@
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include "TFile.h"
+#include "TROOT.h"
 
+#include <algorithm>
 #include <ctime>
+#include <iterator>
 #include <map>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -48,11 +52,35 @@ namespace art {
                           "InputSource"}
     , dropDescendants_{config().dropDescendantsOfDroppedBranches()}
     , readParameterSets_{config().readParameterSets()}
+    , readAhead_{config().readAhead()}
+    , parallelUnzip_{config().parallelUnzip()}
+    , reportReadStatistics_{config().reportReadStatistics()}
+    , pruneUnreadProductsAfter_{config().pruneUnreadProductsAfter()}
+    , reorderWindow_{config().reorderWindow()}
+    , fileOpenPipeline_{config().fileOpenLookAhead() == 0u ?
+                          nullptr :
+                          std::make_unique<detail::FileOpenPipeline>(
+                            config().fileOpenLookAhead())}
+    , eventIndex_{config().eventIndex().empty() ?
+                    nullptr :
+                    std::make_unique<detail::EventIndexReader>(
+                      config().eventIndex())}
     , processingLimits_{limits}
     , processConfiguration_{processConfig}
     , outputCallbacks_{outputCallbacks}
   {
     root::setup();
+    // ROOT's implicit multi-threading affects the whole process; it is
+    // up to the job, not to its input source, to enable it.
+    if (readAhead_ && parallelUnzip_ && !ROOT::IsImplicitMTEnabled()) {
+      throw Exception{errors::Configuration,
+                      "An error occurred while creating the RootInput "
+                      "source.\n"}
+        << "'parallelUnzip' requires ROOT's implicit multi-threading, "
+           "which is not enabled.\n"
+        << "Enable it before the input source is constructed (e.g. in a "
+           "service), or set 'parallelUnzip' to 'false'.\n";
+    }
 
     auto const& primaryFileNames = catalog_.fileSources();
 
@@ -227,11 +255,15 @@ namespace art {
         // Now get the event from the correct file.
         bool const found [[maybe_unused]] = rootFile_->setEntry(eID, exact);
         assert(found);
-        break;
+        return rootFile_->eventIDForFileIndexPosition();
       }
     }
 
-    // Look for event in files not yet opened.
+    // Look for event in files not yet opened: first in the file the event
+    // index lists for it, if any.
+    if (openIndexedFile(eID, exact)) {
+      return rootFile_->eventIDForFileIndexPosition();
+    }
     while (catalog_.getNextFile()) {
       rootFile_ = initFile();
       if (rootFile_->setEntry(eID, exact)) {
@@ -242,6 +274,50 @@ namespace art {
     return EventID();
   }
 
+  bool
+  RootInputFileSequence::openIndexedFile(EventID const& eID, bool const exact)
+  {
+    if (!eventIndex_) {
+      return false;
+    }
+    auto const fileName = eventIndex_->fileContaining(eID);
+    if (!fileName) {
+      return false;
+    }
+    auto const& fileNames = catalog_.fileSources();
+    auto const it = std::find(fileNames.cbegin(), fileNames.cend(), *fileName);
+    if (it == fileNames.cend()) {
+      return false;
+    }
+    // Only the files after the current one have not been opened yet.
+    auto const index =
+      static_cast<std::size_t>(std::distance(fileNames.cbegin(), it));
+    auto const current = catalog_.currentIndex();
+    if (index <= current) {
+      return false;
+    }
+    // Move the catalog on to that file, without opening the files in
+    // between.
+    while (catalog_.currentIndex() < index && catalog_.getNextFile()) {
+    }
+    if (catalog_.currentIndex() == index) {
+      rootFile_ = initFile();
+      if (rootFile_->setEntry(eID, exact)) {
+        return true;
+      }
+    }
+    // The index does not describe this file set; stop using it, and
+    // return to the file from which the search without it starts.
+    mf::LogWarning("EventIndex")
+      << "The event index lists event " << eID << " in file " << *fileName
+      << ",\nwhich is not among the remaining input files or does not "
+         "contain it.  The event index will no longer be used.\n";
+    eventIndex_.reset();
+    catalog_.rewindTo(current);
+    rootFile_ = initFile();
+    return false;
+  }
+
   EventID
   RootInputFileSequence::seekToEvent(int offset)
   {
@@ -253,6 +329,9 @@ namespace art {
   void
   RootInputFileSequence::endJob()
   {
+    if (fileOpenPipeline_) {
+      fileOpenPipeline_->cancel();
+    }
     closeFile_();
   }
 
@@ -315,10 +394,21 @@ namespace art {
     try {
       detail::logFileAction("Initiating request to open input file ",
                             catalog_.currentFile().fileName());
-      filePtr.reset(TFile::Open(catalog_.currentFile().fileName().c_str()));
+      std::optional<std::unique_ptr<TFile>> prefetched;
+      if (fileOpenPipeline_) {
+        prefetched = fileOpenPipeline_->take(catalog_.currentFile().fileName());
+      }
+      if (prefetched) {
+        filePtr = std::move(*prefetched);
+      } else {
+        filePtr.reset(TFile::Open(catalog_.currentFile().fileName().c_str()));
+      }
     }
     catch (cet::exception& e) {
       if (!skipBadFiles) {
+        if (fileOpenPipeline_) {
+          fileOpenPipeline_->cancel();
+        }
         throw Exception(errors::FileOpenError)
           << e.explain_self()
           << "\nRootInputFileSequence::initFile(): Input file "
@@ -326,8 +416,13 @@ namespace art {
           << " was not found or could not be opened.\n";
       }
     }
+    // Start opening the files that follow while this one is set up.
+    scheduleFileOpens();
     if (!filePtr || filePtr->IsZombie()) {
       if (!skipBadFiles) {
+        if (fileOpenPipeline_) {
+          fileOpenPipeline_->cancel();
+        }
         throw Exception(errors::FileOpenError)
           << "RootInputFileSequence::initFile(): Input file "
           << catalog_.currentFile().fileName()
@@ -373,6 +468,11 @@ namespace art {
                                              dropDescendants_,
                                              readParameterSets_,
                                              outputCallbacks_,
+                                             readAhead_,
+                                             parallelUnzip_,
+                                             reportReadStatistics_,
+                                             pruneUnreadProductsAfter_,
+                                             reorderWindow_,
                                              secondary_opener,
                                              duplicateChecker_);
 
@@ -384,6 +484,20 @@ namespace art {
     return result;
   }
 
+  void
+  RootInputFileSequence::scheduleFileOpens()
+  {
+    if (!fileOpenPipeline_) {
+      return;
+    }
+    auto const& fileNames = catalog_.fileSources();
+    auto const next = catalog_.currentIndex() + 1;
+    if (next >= fileNames.size()) {
+      return;
+    }
+    fileOpenPipeline_->schedule(fileNames.cbegin() + next, fileNames.cend());
+  }
+
   RootInputFile&
   RootInputFileSequence::secondaryFile(int const idx)
   {
@@ -428,7 +542,10 @@ namespace art {
                                            groupSelectorRules_,
                                            dropDescendants_,
                                            readParameterSets_,
-                                           outputCallbacks_);
+                                           outputCallbacks_,
+                                           readAhead_,
+                                           parallelUnzip_,
+                                           reportReadStatistics_);
     return *file;
   }
 
@@ -556,7 +673,12 @@ namespace art {
       }
     }
 
-    // Look for event in files not yet opened.
+    // Look for event in files not yet opened: first in the file the event
+    // index lists for it, if any.
+    if (openIndexedFile(id, exact)) {
+      rootFileForLastReadEvent_ = rootFile_;
+      return;
+    }
     while (catalog_.getNextFile()) {
       rootFile_ = initFile();
       if (rootFile_->setEntry(id, exact)) {
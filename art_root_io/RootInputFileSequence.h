@@ -8,6 +8,8 @@
 #include "art_root_io/DuplicateChecker.h"
 #include "art_root_io/Inputfwd.h"
 #include "art_root_io/RootInputFile.h"
+#include "art_root_io/detail/EventIndexDB.h"
+#include "art_root_io/detail/FileOpenPipeline.h"
 #include "canvas/Persistency/Provenance/EventID.h"
 #include "canvas/Persistency/Provenance/fwd.h"
 #include "fhiclcpp/types/Atom.h"
@@ -71,6 +73,83 @@ namespace art {
         Name("dropDescendantsOfDroppedBranches"),
         true};
       Atom<bool> readParameterSets{Name("readParameterSets"), true};
+      Atom<bool> readAhead{
+        Name("readAhead"),
+        Comment(
+          "If 'readAhead' is 'true', the TTreeCache of the Events tree is\n"
+          "primed with exactly the branches that survive 'inputCommands'\n"
+          "(instead of learning them from the first reads), whole clusters\n"
+          "are prefetched, and the cache is restricted to the entries that\n"
+          "the FileIndex says will be read.  If 'cacheSize' is 0, ROOT's\n"
+          "default cache size is used."),
+        false};
+      Atom<bool> parallelUnzip{
+        Name("parallelUnzip"),
+        Comment(
+          "If 'parallelUnzip' is 'true' (and 'readAhead' is 'true'), the\n"
+          "prefetched baskets are decompressed in the background by ROOT's\n"
+          "implicit multi-threading pool.  The job must enable ROOT's\n"
+          "implicit multi-threading itself, before the input source is\n"
+          "constructed; the configuration fails otherwise."),
+        false};
+      Atom<bool> reportReadStatistics{
+        Name("reportReadStatistics"),
+        Comment(
+          "If 'reportReadStatistics' is 'true', the TTreeCache efficiency,\n"
+          "the number of baskets unzipped in the background if\n"
+          "'parallelUnzip' is 'true', and, for each product branch that was\n"
+          "read, the number of reads, the fraction served without a file\n"
+          "read, and the time spent waiting for the read are logged when\n"
+          "each input file is closed."),
+        false};
+      Atom<unsigned> pruneUnreadProductsAfter{
+        Name("pruneUnreadProductsAfter"),
+        Comment(
+          "If 'pruneUnreadProductsAfter' is non-zero, the branches of the\n"
+          "event products that have not been read by the time that many\n"
+          "events of an input file have been processed are deactivated and\n"
+          "removed from the TTreeCache, so that the rest of the file is read\n"
+          "only for the products the job actually uses.  A deactivated\n"
+          "product that is requested later is read as usual, and its branch\n"
+          "is reactivated.  Until the branches are deactivated, event\n"
+          "products are read on demand, irrespective of\n"
+          "'delayedReadEventProducts'; afterwards, if it is 'false', the\n"
+          "products of the active branches are read immediately."),
+        0u};
+      Atom<unsigned> reorderWindow{
+        Name("reorderWindow"),
+        Comment(
+          "If 'reorderWindow' is greater than 1 (and 'noEventSort' is\n"
+          "'false'), the events are read that many at a time, in the order\n"
+          "in which they are stored in the Events tree, together with the\n"
+          "products already read from the input file.  They are then handed\n"
+          "out in EventID order.  Merged or concatenated files are thus read\n"
+          "sequentially, at the cost of holding up to 'reorderWindow' events\n"
+          "in memory."),
+        0u};
+      Atom<unsigned> fileOpenLookAhead{
+        Name("fileOpenLookAhead"),
+        Comment(
+          "If 'fileOpenLookAhead' is non-zero, up to that many of the\n"
+          "primary input files that follow the current one in 'fileNames'\n"
+          "are opened on background threads, and the headers of their art\n"
+          "trees and their metadata trees are loaded, while the current file\n"
+          "is being processed.  A file that fails to open in the background\n"
+          "is skipped or reported at its turn, according to 'skipBadFiles';\n"
+          "if it is reported, the remaining background opens are cancelled.\n"
+          "Files delivered under names other than those in 'fileNames' are\n"
+          "opened when they are reached."),
+        0u};
+      Atom<std::string> eventIndex{
+        Name("eventIndex"),
+        Comment(
+          "If 'eventIndex' is not empty, it names an event index created\n"
+          "by 'event_index_builder' for the files in 'fileNames'.  When an\n"
+          "event is requested that is not in a file opened so far, the\n"
+          "file that the index lists for it is opened directly, instead of\n"
+          "opening each of the remaining files in turn.  Events the index\n"
+          "does not know about are searched for as without an index."),
+        ""};
 
       struct SecondaryFile {
         Atom<std::string> a{Name("a"), ""};
@@ -158,6 +237,8 @@ namespace art {
 
   private:
     std::shared_ptr<RootInputFile> initFile(bool skipBadFiles = false);
+    bool openIndexedFile(EventID const& eID, bool exact);
+    void scheduleFileOpens();
     std::shared_ptr<RootInputFile> nextFile();
     std::shared_ptr<RootInputFile> previousFile();
 
@@ -184,6 +265,13 @@ namespace art {
     std::shared_ptr<DuplicateChecker> duplicateChecker_{nullptr};
     bool const dropDescendants_;
     bool const readParameterSets_;
+    bool const readAhead_;
+    bool const parallelUnzip_;
+    bool const reportReadStatistics_;
+    unsigned const pruneUnreadProductsAfter_;
+    unsigned const reorderWindow_;
+    std::unique_ptr<detail::FileOpenPipeline> fileOpenPipeline_;
+    std::unique_ptr<detail::EventIndexReader> eventIndex_;
     RootInputFileSharedPtr rootFileForLastReadEvent_;
     ProcessingLimits const& processingLimits_;
     ProcessConfiguration const& processConfiguration_;
@@ -11,6 +11,7 @@
 #include "art/Framework/Principal/RunPrincipal.h"
 #include "art/Framework/Principal/SubRunPrincipal.h"
 #include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "art/Framework/Services/Registry/ServiceRegistry.h"
 #include "art/Framework/Services/System/DatabaseConnection.h"
 #include "art/Persistency/Provenance/ProcessHistoryRegistry.h"
 #include "art_root_io/DropMetaData.h"
@@ -18,7 +19,9 @@
 #include "art_root_io/GetFileFormatVersion.h"
 #include "art_root_io/RootDB/TKeyVFSOpenPolicy.h"
 #include "art_root_io/RootFileBlock.h"
+#include "art_root_io/RootIOStatistics.h"
 #include "art_root_io/checkDictionaries.h"
+#include "art_root_io/detail/RangeSetWriter.h"
 #include "art_root_io/detail/getObjectRequireDict.h"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "canvas/Persistency/Provenance/BranchChildren.h"
@@ -40,8 +43,6 @@
 #include "cetlib/exempt_ptr.h"
 #include "cetlib/sqlite/Ntuple.h"
 #include "cetlib/sqlite/Transaction.h"
-#include "cetlib/sqlite/create_table.h"
-#include "cetlib/sqlite/exec.h"
 #include "cetlib/sqlite/insert.h"
 #include "fhiclcpp/ParameterSetRegistry.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
@@ -49,9 +50,12 @@
 
 #include "TBranch.h"
 #include "TFile.h"
+#include "TFileCacheWrite.h"
 #include "TTree.h"
 
 #include <algorithm>
+#include <cassert>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -68,118 +72,6 @@ using std::vector;
 
 namespace {
 
-  void
-  create_table(sqlite3* const db,
-               string const& name,
-               vector<string> const& columns,
-               string const& suffix = {})
-  {
-    if (columns.empty())
-      throw art::Exception(art::errors::LogicError)
-        << "Number of sqlite columns specified for table: " << name << '\n'
-        << "is zero.\n";
-    string ddl = "DROP TABLE IF EXISTS " + name +
-                 "; "
-                 "CREATE TABLE " +
-                 name + "(" + columns.front();
-    for_each(columns.begin() + 1, columns.end(), [&ddl](auto const& col) {
-      ddl += "," + col;
-    });
-    ddl += ") ";
-    ddl += suffix;
-    ddl += ";";
-    sqlite::exec(db, ddl);
-  }
-
-  void
-  insert_eventRanges_row(sqlite3_stmt* stmt,
-                         art::SubRunNumber_t const sr,
-                         art::EventNumber_t const b,
-                         art::EventNumber_t const e)
-  {
-    sqlite3_bind_int64(stmt, 1, sr);
-    sqlite3_bind_int64(stmt, 2, b);
-    sqlite3_bind_int64(stmt, 3, e);
-    sqlite3_step(stmt);
-    sqlite3_reset(stmt);
-  }
-
-  void
-  insert_rangeSets_eventSets_row(sqlite3_stmt* stmt,
-                                 unsigned const rsid,
-                                 unsigned const esid)
-  {
-    sqlite3_bind_int64(stmt, 1, rsid);
-    sqlite3_bind_int64(stmt, 2, esid);
-    sqlite3_step(stmt);
-    sqlite3_reset(stmt);
-  }
-
-  unsigned
-  getNewRangeSetID(sqlite3* db,
-                   art::BranchType const bt,
-                   art::RunNumber_t const r)
-  {
-    sqlite::insert_into(db, art::BranchTypeToString(bt) + "RangeSets")
-      .values(r);
-    return sqlite3_last_insert_rowid(db);
-  }
-
-  vector<unsigned>
-  getExistingRangeSetIDs(sqlite3* db, art::RangeSet const& rs)
-  {
-    using namespace std;
-    vector<unsigned> rangeSetIDs;
-    cet::transform_all(rs, back_inserter(rangeSetIDs), [db](auto const& range) {
-      sqlite::query_result<unsigned> r;
-      r << sqlite::select("ROWID")
-             .from(db, "EventRanges")
-             .where("SubRun=" + to_string(range.subRun()) +
-                    " AND "
-                    "begin=" +
-                    to_string(range.begin()) +
-                    " AND "
-                    "end=" +
-                    to_string(range.end()));
-      return unique_value(r);
-    });
-    return rangeSetIDs;
-  }
-
-  void
-  insertIntoEventRanges(sqlite3* db, art::RangeSet const& rs)
-  {
-    sqlite::Transaction txn{db};
-    sqlite3_stmt* stmt{nullptr};
-    string const ddl{"INSERT INTO EventRanges(SubRun, begin, end) "
-                     "VALUES(?, ?, ?);"};
-    sqlite3_prepare_v2(db, ddl.c_str(), -1, &stmt, nullptr);
-    for (auto const& range : rs) {
-      insert_eventRanges_row(stmt, range.subRun(), range.begin(), range.end());
-    }
-    sqlite3_finalize(stmt);
-    txn.commit();
-  }
-
-  void
-  insertIntoJoinTable(sqlite3* db,
-                      art::BranchType const bt,
-                      unsigned const rsID,
-                      vector<unsigned> const& eventRangesIDs)
-  {
-    sqlite::Transaction txn{db};
-    sqlite3_stmt* stmt{nullptr};
-    string const ddl{
-      "INSERT INTO " + art::BranchTypeToString(bt) +
-      "RangeSets_EventRanges(RangeSetsID, EventRangesID) Values(?,?);"};
-    sqlite3_prepare_v2(db, ddl.c_str(), -1, &stmt, nullptr);
-    cet::for_all(eventRangesIDs, [stmt, rsID](auto const eventRangeID) {
-      insert_rangeSets_eventSets_row(stmt, rsID, eventRangeID);
-    });
-    sqlite3_finalize(stmt);
-    txn.commit();
-  }
-
   void
   maybeInvalidateRangeSet(BranchType const bt,
                           art::RangeSet const& principalRS,
@@ -275,9 +167,8 @@ namespace {
   template <BranchType BT>
   void
   setProductRangeSetID(art::RangeSet const& rs,
-                       sqlite3* db,
-                       art::EDProduct* product,
-                       map<unsigned, unsigned>& checksumToIndexLookup)
+                       art::detail::RangeSetWriter& rangeSetWriter,
+                       art::EDProduct* product)
   {
     if constexpr (!art::detail::range_sets_supported(BT)) {
       return;
@@ -287,17 +178,7 @@ namespace {
       return;
     }
     // Set range sets for SubRun and Run products
-    auto it = checksumToIndexLookup.find(rs.checksum());
-    if (it != checksumToIndexLookup.cend()) {
-      product->setRangeSetID(it->second);
-    } else {
-      unsigned const rsID = getNewRangeSetID(db, BT, rs.run());
-      product->setRangeSetID(rsID);
-      checksumToIndexLookup.emplace(rs.checksum(), rsID);
-      insertIntoEventRanges(db, rs);
-      auto const& eventRangesIDs = getExistingRangeSetIDs(db, rs);
-      insertIntoJoinTable(db, BT, rsID, eventRangesIDs);
-    }
+    product->setRangeSetID(rangeSetWriter.rangeSetID(BT, rs));
   }
 
 } // unnamed namespace
@@ -321,7 +202,15 @@ namespace art {
                                  int const splitLevel,
                                  int const basketSize,
                                  DropMetaData dropMetaData,
-                                 bool const dropMetaDataForDroppedData)
+                                 bool const dropMetaDataForDroppedData,
+                                 bool const parallelBasketCompression,
+                                 int const writeCacheSize,
+                                 int const rootFileDBPageSize,
+                                 unsigned const basketOptimizationEntries,
+                                 int64_t const basketMemoryBudget,
+                                 int64_t const clusterSize,
+                                 cet::exempt_ptr<detail::CompressionRules const>
+                                   compressionRules)
     : om_{om}
     , file_{fileName}
     , fileSwitchCriteria_{fileSwitchCriteria}
@@ -333,8 +222,14 @@ namespace art {
     , dropMetaData_{dropMetaData}
     , dropMetaDataForDroppedData_{dropMetaDataForDroppedData}
     , filePtr_{TFile::Open(file_.c_str(), "recreate", "", compressionLevel)}
+    , optimizeLayout_{basketOptimizationEntries != 0u}
+    , compressionRules_{compressionRules}
   {
     using std::make_unique;
+    if (writeCacheSize > 0) {
+      // The write cache is owned, flushed and deleted by the file.
+      new TFileCacheWrite(filePtr_.get(), writeCacheSize);
+    }
     // Don't split metadata tree or event description tree
     metaDataTree_ = RootOutputTree::makeTTree(
       filePtr_.get(), rootNames::metaDataTreeName(), 0);
@@ -350,7 +245,8 @@ namespace art {
                                   basketSize,
                                   splitLevel,
                                   treeMaxVirtualSize,
-                                  saveMemoryObjectThreshold);
+                                  saveMemoryObjectThreshold,
+                                  parallelBasketCompression);
     treePointers_[1] =
       make_unique<RootOutputTree>(filePtr_.get(),
                                   InSubRun,
@@ -359,7 +255,8 @@ namespace art {
                                   basketSize,
                                   splitLevel,
                                   treeMaxVirtualSize,
-                                  saveMemoryObjectThreshold);
+                                  saveMemoryObjectThreshold,
+                                  parallelBasketCompression);
     treePointers_[2] = make_unique<RootOutputTree>(filePtr_.get(),
                                                    InRun,
                                                    pRunAux_,
@@ -367,7 +264,8 @@ namespace art {
                                                    basketSize,
                                                    splitLevel,
                                                    treeMaxVirtualSize,
-                                                   saveMemoryObjectThreshold);
+                                                   saveMemoryObjectThreshold,
+                                                   parallelBasketCompression);
     treePointers_[3] =
       make_unique<RootOutputTree>(filePtr_.get(),
                                   InResults,
@@ -376,12 +274,29 @@ namespace art {
                                   basketSize,
                                   splitLevel,
                                   treeMaxVirtualSize,
-                                  saveMemoryObjectThreshold);
+                                  saveMemoryObjectThreshold,
+                                  parallelBasketCompression);
     rootFileDB_ = ServiceHandle<DatabaseConnection>
     {
       } -> get<TKeyVFSOpenPolicy>("RootFileDB",
                                   filePtr_.get(),
-                                  SQLITE_OPEN_CREATE | SQLITE_OPEN_READWRITE);
+                                  SQLITE_OPEN_CREATE | SQLITE_OPEN_READWRITE,
+                                  rootFileDBPageSize);
+    if (optimizeLayout_) {
+      for (auto const& tree : treePointers_) {
+        tree->setLayoutOptimization(
+          basketOptimizationEntries, basketMemoryBudget, clusterSize);
+      }
+    }
+    if (compressionRules_ && !compressionRules_->empty()) {
+      for (auto const& tree : treePointers_) {
+        tree->setCompressionRules(compressionRules_);
+      }
+    }
+    if (ServiceRegistry::isAvailable<RootIOStatistics>()) {
+      ioStatistics_ = ServiceHandle<RootIOStatistics>{}.get();
+      cet::for_all(treePointers_, [](auto const& p) { p->recordStatistics(); });
+    }
     beginTime_ = std::chrono::steady_clock::now();
     // Check that dictionaries for the auxiliaries exist
     root::DictionaryChecker checker;
@@ -390,30 +305,8 @@ namespace art {
     checker.checkDictionaries<RunAuxiliary>();
     checker.checkDictionaries<ResultsAuxiliary>();
     checker.reportMissingDictionaries();
-    // Event ranges
-    create_table(*rootFileDB_,
-                 "EventRanges",
-                 {"SubRun INTEGER",
-                  "begin INTEGER",
-                  "end INTEGER",
-                  "UNIQUE (SubRun,begin,end) ON CONFLICT IGNORE"});
-    // SubRun range sets
-    using namespace cet::sqlite;
-    create_table(*rootFileDB_, "SubRunRangeSets", column<int>{"Run"});
-    create_table(*rootFileDB_,
-                 "SubRunRangeSets_EventRanges",
-                 {"RangeSetsID INTEGER",
-                  "EventRangesID INTEGER",
-                  "PRIMARY KEY(RangeSetsID,EventRangesID)"},
-                 "WITHOUT ROWID");
-    // Run range sets
-    create_table(*rootFileDB_, "RunRangeSets", column<int>{"Run"});
-    create_table(*rootFileDB_,
-                 "RunRangeSets_EventRanges",
-                 {"RangeSetsID INTEGER",
-                  "EventRangesID INTEGER",
-                  "PRIMARY KEY(RangeSetsID,EventRangesID)"},
-                 "WITHOUT ROWID");
+    detail::RangeSetWriter::createTables(*rootFileDB_);
+    rangeSetWriter_ = std::make_unique<detail::RangeSetWriter>(*rootFileDB_);
   }
 
   void
@@ -436,6 +329,10 @@ namespace art {
     std::lock_guard sentry{mutex_};
     auto selectProductsToWrite = [this](BranchType const bt) {
       auto& items = selectedOutputItemList_[bt];
+      std::set<ProductID> selected;
+      for (auto const& item : items) {
+        selected.insert(item.branchDescription.productID());
+      }
       for (auto const& pd : om_->keptProducts()[bt] | ranges::views::values) {
         // Persist Results products only if they have been produced by
         // the current process.
@@ -450,12 +347,15 @@ namespace art {
         if (pd.transient()) {
           continue;
         }
-        items.try_emplace(pd.productID(), pd);
+        if (selected.insert(pd.productID()).second) {
+          items.emplace_back(pd);
+        }
       }
-      for (auto const& item : items | ranges::views::values) {
+      for (auto& item : items) {
         treePointers_[bt]->addOutputBranch(item.branchDescription,
                                            item.product);
       }
+      selectionPersisted_[bt] = false;
     };
     for_each_branch_type(selectProductsToWrite);
   }
@@ -465,11 +365,17 @@ namespace art {
                                  FastCloningEnabled fastCloningEnabled)
   {
     std::lock_guard sentry{mutex_};
+    bool const firstInputFile{std::exchange(firstInputFile_, false)};
 
     // Create output branches, and then redo calculation to determine
     // if fast cloning should be done.
     selectProducts();
 
+    // Whether the trees are fast cloned is decided afresh for each
+    // input file.
+    wasFastCloned_.fill(false);
+    cet::for_all(treePointers_, [](auto const& p) { p->endFastCloning(); });
+
     cet::exempt_ptr<TTree const> inputTree{nullptr};
     if (rfb) {
       if (rfb->fileFormatVersion().value_ < 10) {
@@ -498,7 +404,59 @@ namespace art {
 
     mf::LogInfo("FastCloning")
       << "Fast cloning event data products from input file.";
-    wasFastCloned_ = treePointers_[InEvent]->fastCloneTree(inputTree);
+    wasFastCloned_[InEvent] = treePointers_[InEvent]->fastCloneTree(inputTree);
+    if (rfb) {
+      fastCloneRunsAndSubRuns(*rfb, firstInputFile);
+    }
+  }
+
+  void
+  RootOutputFile::fastCloneRunsAndSubRuns(RootFileBlock const& rfb,
+                                          bool const firstInputFile)
+  {
+    // Cloned products refer to their RangeSets by the IDs of the input
+    // file's RootFileDB, which start from 1 in every file.  Those of a
+    // later input file are therefore already used for other RangeSets
+    // in this file, and cannot be remapped without rewriting the
+    // products.
+    auto enabled = rfb.runsAndSubRunsFastClonable();
+    if (!firstInputFile) {
+      enabled.disable("Run and subrun data products are fast cloned only "
+                      "from the first input file of an output file.");
+    }
+    if (!enabled) {
+      mf::LogInfo("FastCloning")
+        << "Run and subrun data products are not fast cloned.\n"
+        << enabled.disabledBecause();
+      return;
+    }
+    std::array<std::pair<BranchType, cet::exempt_ptr<TTree const>>, 2> const
+      inputTrees{{{InSubRun, rfb.subRunTree()}, {InRun, rfb.runTree()}}};
+    for (auto const& [bt, inputTree] : inputTrees) {
+      auto const& name = BranchTypeToString(bt);
+      if (!treePointers_[bt]->checkSplitLevelAndBasketSize(inputTree)) {
+        mf::LogInfo("FastCloning")
+          << name << " data products are not fast cloned: the splitting "
+          << "level and/or basket size does not match between input and "
+          << "output file.";
+        continue;
+      }
+      // The products keep the IDs of their RangeSets in the input
+      // file, so the RangeSets must have the same IDs in this file.
+      if (!rangeSetWriter_->import(bt,
+                                   rfb.rangeSetResolver()->rangeSets(bt))) {
+        mf::LogInfo("FastCloning")
+          << name << " data products are not fast cloned: the IDs of "
+          << "their RangeSets are already used in the output file.";
+        continue;
+      }
+      wasFastCloned_[bt] = treePointers_[bt]->fastCloneTree(inputTree);
+      if (wasFastCloned_[bt]) {
+        mf::LogInfo("FastCloning")
+          << "Fast cloned " << name << " data products from input file ("
+          << inputTree->GetEntries() << " entries).";
+      }
+    }
   }
 
   void
@@ -557,6 +515,7 @@ namespace art {
     pSubRunAux_ = &sr.subRunAux();
     pSubRunAux_->setRangeSetID(subRunRSID_);
     fillBranches<InSubRun>(sr, pSubRunProductProvenanceVector_);
+    rangeSetWriter_->flush();
     fileIndex_.addEntry(EventID::invalidEvent(pSubRunAux_->subRunID()),
                         fp_.subRunEntryNumber());
     fp_.update_subRun(status_);
@@ -569,6 +528,7 @@ namespace art {
     pRunAux_ = &r.runAux();
     pRunAux_->setRangeSetID(runRSID_);
     fillBranches<InRun>(r, pRunProductProvenanceVector_);
+    rangeSetWriter_->flush();
     fileIndex_.addEntry(EventID::invalidEvent(pRunAux_->runID()),
                         fp_.runEntryNumber());
     fp_.update_run(status_);
@@ -805,31 +765,109 @@ namespace art {
   RootOutputFile::writeTTrees()
   {
     std::lock_guard sentry{mutex_};
+    rangeSetWriter_->flush();
     RootOutputTree::writeTTree(metaDataTree_);
     RootOutputTree::writeTTree(fileIndexTree_);
     RootOutputTree::writeTTree(parentageTree_);
     for_each_branch_type(
       [this](BranchType const bt) { treePointers_[bt]->writeTree(); });
+    // After writeTree(), which sets the auto-flush of trees filled with
+    // parallel basket compression.
+    if (optimizeLayout_) {
+      writeLayout();
+    }
+    if (compressionRules_ && !compressionRules_->empty()) {
+      writeCompressionReport();
+    }
+    if (ioStatistics_) {
+      for (auto const& tree : treePointers_) {
+        tree->reportStatistics(*ioStatistics_, file_);
+      }
+    }
+  }
+
+  void
+  RootOutputFile::writeLayout()
+  {
+    using namespace cet::sqlite;
+    Ntuple<string, string, int> basketLayout{
+      *rootFileDB_, "BasketLayout", {{"Tree", "Branch", "BasketSize"}}, true};
+    Ntuple<string, int> clusterLayout{
+      *rootFileDB_, "ClusterLayout", {{"Tree", "EntriesPerCluster"}}, true};
+    for (auto const& tree : treePointers_) {
+      for (auto* t : {tree->tree(), tree->metaTree()}) {
+        std::string const treeName{t->GetName()};
+        clusterLayout.insert(treeName, static_cast<int>(t->GetAutoFlush()));
+        for (auto* obj : *t->GetListOfBranches()) {
+          auto* br = static_cast<TBranch*>(obj);
+          basketLayout.insert(treeName, br->GetName(), br->GetBasketSize());
+        }
+      }
+    }
+  }
+
+  void
+  RootOutputFile::writeCompressionReport()
+  {
+    // The read throughput of each rule follows from the per-branch
+    // read times gathered by the RootIOStatistics service, joined with
+    // the BranchCompression table on the branch name.  The sizes are
+    // those of the branches once their baskets have been written, so
+    // they do not depend on how the trees were filled.
+    using namespace cet::sqlite;
+    auto const& rules = *compressionRules_;
+    std::vector<detail::CompressionRules::Usage> usage(rules.size());
+    Ntuple<string, string, int> branchCompression{
+      *rootFileDB_, "BranchCompression", {{"Tree", "Branch", "Rule"}}, true};
+    for (auto const& tree : treePointers_) {
+      tree->reportCompression(usage);
+      for (auto const& [br, rule] : tree->branchRules()) {
+        branchCompression.insert(
+          br->GetTree()->GetName(), br->GetName(), static_cast<int>(rule));
+      }
+    }
+    Ntuple<int, string, string, int, int, double, double, double, double>
+      compressionRules{*rootFileDB_,
+                       "CompressionRules",
+                       {{"Rule",
+                         "Pattern",
+                         "Algorithm",
+                         "Level",
+                         "Branches",
+                         "UncompressedMB",
+                         "CompressedMB",
+                         "WriteTime",
+                         "WriteMBPerSecond"}},
+                       true};
+    for (std::size_t i = 0; i != rules.size(); ++i) {
+      auto const& u = usage[i];
+      double const uncompressedMB = u.uncompressedBytes / 1.e6;
+      double const writeTime =
+        std::chrono::duration<double>{u.writeTime}.count();
+      compressionRules.insert(static_cast<int>(i),
+                              rules[i].pattern,
+                              rules[i].algorithm,
+                              rules[i].level,
+                              static_cast<int>(u.branches),
+                              uncompressedMB,
+                              u.compressedBytes / 1.e6,
+                              writeTime,
+                              writeTime > 0. ? uncompressedMB / writeTime : 0.);
+    }
   }
 
   void
   RootOutputFile::setSubRunAuxiliaryRangeSetID(RangeSet const& ranges)
   {
     std::lock_guard sentry{mutex_};
-    subRunRSID_ = getNewRangeSetID(*rootFileDB_, InSubRun, ranges.run());
-    insertIntoEventRanges(*rootFileDB_, ranges);
-    auto const& eventRangesIDs = getExistingRangeSetIDs(*rootFileDB_, ranges);
-    insertIntoJoinTable(*rootFileDB_, InSubRun, subRunRSID_, eventRangesIDs);
+    subRunRSID_ = rangeSetWriter_->rangeSetID(InSubRun, ranges);
   }
 
   void
   RootOutputFile::setRunAuxiliaryRangeSetID(RangeSet const& ranges)
   {
     std::lock_guard sentry{mutex_};
-    runRSID_ = getNewRangeSetID(*rootFileDB_, InRun, ranges.run());
-    insertIntoEventRanges(*rootFileDB_, ranges);
-    auto const& eventRangesIDs = getExistingRangeSetIDs(*rootFileDB_, ranges);
-    insertIntoJoinTable(*rootFileDB_, InRun, runRSID_, eventRangesIDs);
+    runRSID_ = rangeSetWriter_->rangeSetID(InRun, ranges);
   }
 
   template <BranchType BT>
@@ -848,14 +886,97 @@ namespace art {
                           dummyProductCache_.product(wrappedName);
   }
 
+  bool
+  RootOutputFile::markKept(ProductID const pid)
+  {
+    auto& epoch = keptEpochs_[pid];
+    if (epoch == keptEpoch_) {
+      return false;
+    }
+    epoch = keptEpoch_;
+    return true;
+  }
+
+  std::vector<ProductID> const&
+  RootOutputFile::producedParents(BranchType const bt,
+                                  Principal const& principal,
+                                  ProductProvenance const& pp)
+  {
+    auto& cache = producedParents_[bt];
+    auto const parentageID = pp.parentageID();
+    if (auto it = cache.find(parentageID); it != cache.cend()) {
+      return it->second;
+    }
+    std::vector<ProductID> parents;
+    bool complete{true};
+    for (auto const parent_bid : pp.parentage().parents()) {
+      // Note: Suppose the parent ProductID corresponds to product that
+      //       has been requested to be "dropped"--i.e. someone has
+      //       specified "drop *_m1a_*_*" in their configuration, and
+      //       although a given product matching this pattern will not
+      //       be included in the selectedProducts_ list, one of the
+      //       parents of a selected product can match the "dropping"
+      //       pattern and its BranchDescription will still be written
+      //       to disk since it is inserted into the
+      //       descriptionsToPersist_ data member.
+      auto parent_bd = principal.getProductDescription(parent_bid);
+      if (!parent_bd) {
+        // FIXME: Is this an error condition?
+        complete = false;
+        continue;
+      }
+      descriptionsToPersist_[bt].try_emplace(parent_bid, *parent_bd);
+      if (!parent_bd->produced()) {
+        // We got it from the input, nothing to do.
+        continue;
+      }
+      parents.push_back(parent_bid);
+    }
+    if (!complete) {
+      // Retry with the next principal that has this parentage.
+      uncachedParents_ = std::move(parents);
+      return uncachedParents_;
+    }
+    return cache.emplace(parentageID, std::move(parents)).first->second;
+  }
+
+  void
+  RootOutputFile::keepAncestors(BranchType const bt,
+                                Principal const& principal,
+                                ProductProvenance const& pp,
+                                bool const keepParentProvenance,
+                                std::vector<ProductProvenance>& kept)
+  {
+    ancestors_.assign(1, &pp);
+    while (!ancestors_.empty()) {
+      auto const* current_pp = ancestors_.back();
+      ancestors_.pop_back();
+      auto const& parents = producedParents(bt, principal, *current_pp);
+      if (!keepParentProvenance) {
+        continue;
+      }
+      for (auto const parent_bid : parents) {
+        auto parent_pp = principal.branchToProductProvenance(parent_bid);
+        if (!parent_pp) {
+          continue;
+        }
+        if (!markKept(parent_bid)) {
+          // Already there, done.
+          continue;
+        }
+        kept.push_back(*parent_pp);
+        ancestors_.push_back(parent_pp.get());
+      }
+    }
+  }
+
   template <BranchType BT>
   void
   RootOutputFile::fillBranches(Principal const& principal,
                                vector<ProductProvenance>* vpp)
   {
     std::lock_guard sentry{mutex_};
-    bool const fastCloning{BT == InEvent && wasFastCloned_};
-    map<unsigned, unsigned> checksumToIndex;
+    bool const fastCloning{wasFastCloned_[BT]};
     auto const& principalRS = principal.seenRanges();
 
     // Local variables to avoid many functions calls to
@@ -864,10 +985,24 @@ namespace art {
     bool const drop_prior_metadata{dropMetaData_ == DropMetaData::DropPrior};
     bool const drop_all_metadata{dropMetaData_ == DropMetaData::DropAll};
 
-    std::set<ProductProvenance> keptprv;
-    for (auto const& [pid, val] : selectedOutputItemList_[BT]) {
+    if (!selectionPersisted_[BT]) {
+      for (auto const& val : selectedOutputItemList_[BT]) {
+        auto const& bd = val.branchDescription;
+        descriptionsToPersist_[BT].try_emplace(bd.productID(), bd);
+      }
+      selectionPersisted_[BT] = true;
+    }
+
+    // The kept provenance is collected in *vpp, whose capacity is
+    // reused from one fill to the next, and is sorted once all
+    // products have been seen.  As with insertion into a set, the
+    // first entry recorded for a product is the one that is kept.
+    vpp->clear();
+    ++keptEpoch_;
+    dummyProvenance_.clear();
+    for (auto& val : selectedOutputItemList_[BT]) {
       auto const& bd = val.branchDescription;
-      descriptionsToPersist_[BT].try_emplace(pid, bd);
+      auto const pid = bd.productID();
       bool const produced = bd.produced();
       bool const resolveProd{produced || !fastCloning ||
                              treePointers_[BT]->uncloned(bd.branchName())};
@@ -875,56 +1010,16 @@ namespace art {
       bool const keepProvenance =
         drop_no_metadata || (produced && drop_prior_metadata);
       auto const& oh = principal.getForOutput(pid, resolveProd);
-      auto prov = keptprv.begin();
       if (keepProvenance) {
+        markKept(pid);
         if (oh.productProvenance()) {
-          prov = keptprv.insert(*oh.productProvenance()).first;
+          vpp->push_back(*oh.productProvenance());
           if (!drop_all_metadata && !dropMetaDataForDroppedData_) {
-            {
-              vector<ProductProvenance const*> stacked_pp;
-              stacked_pp.push_back(&*oh.productProvenance());
-              while (not empty(stacked_pp)) {
-                auto current_pp = stacked_pp.back();
-                stacked_pp.pop_back();
-                for (auto const parent_bid :
-                     current_pp->parentage().parents()) {
-                  // Note: Suppose the parent ProductID corresponds to
-                  //       product that has been requested to be
-                  //       "dropped"--i.e. someone has specified "drop
-                  //       *_m1a_*_*" in their configuration, and
-                  //       although a given product matching this
-                  //       pattern will not be included in the
-                  //       selectedProducts_ list, one of the parents of
-                  //       a selected product can match the "dropping"
-                  //       pattern and its BranchDescription will still
-                  //       be written to disk since it is inserted into
-                  //       the descriptionsToPersist_ data member.
-                  auto parent_bd = principal.getProductDescription(parent_bid);
-                  if (!parent_bd) {
-                    // FIXME: Is this an error condition?
-                    continue;
-                  }
-                  descriptionsToPersist_[BT].try_emplace(parent_bid,
-                                                         *parent_bd);
-                  if (!parent_bd->produced()) {
-                    // We got it from the input, nothing to do.
-                    continue;
-                  }
-                  auto parent_pp =
-                    principal.branchToProductProvenance(parent_bid);
-                  if (!parent_pp || !drop_no_metadata) {
-                    continue;
-                  }
-                  if (!keptprv.insert(*parent_pp).second) {
-                    // Already there, done.
-                    continue;
-                  }
-                  if (!drop_all_metadata && !dropMetaDataForDroppedData_) {
-                    stacked_pp.push_back(parent_pp.get());
-                  }
-                }
-              }
-            }
+            keepAncestors(BT,
+                          principal,
+                          *oh.productProvenance(),
+                          drop_no_metadata,
+                          *vpp);
           }
         } else {
           // No provenance: product was either not produced, or was
@@ -933,7 +1028,7 @@ namespace art {
           if (produced) {
             status = productstatus::neverCreated();
           }
-          prov = keptprv.emplace(pid, status).first;
+          vpp->emplace_back(pid, status);
         }
       }
       // Resolve the product if we are going to attempt to write it out.
@@ -943,7 +1038,8 @@ namespace art {
         // able to get a pointer to it from the passed principal and
         // write it out.
         auto const& rs = getRangeSet<BT>(oh, principalRS, produced);
-        if (detail::range_sets_supported(BT) && !rs.is_valid()) {
+        if (detail::range_sets_supported(BT) && !rs.is_valid() &&
+            keepProvenance) {
           // At this point we are now going to write out a dummy product
           // whose Wrapper present flag is false because the range set
           // got invalidated to present double counting when combining
@@ -953,24 +1049,29 @@ namespace art {
           // requirement is only that the status not be
           // productstatus::present().  We use a special code to make it
           // easier for humans to tell what is going on.
-          auto prov_bid = prov->productID();
-          if (keptprv.erase(*prov) != 1ull) {
-            throw Exception(errors::LogicError, "KeptProvenance::setStatus")
-              << "Attempt to set product status for product whose provenance "
-                 "is not being recorded.\n";
-          }
-          prov =
-            keptprv
-              .emplace(prov_bid, productstatus::dummyToPreventDoubleCount())
-              .first;
+          dummyProvenance_.push_back(pid);
         }
         auto const* product = getProduct<BT>(oh, rs, bd.wrappedName());
         setProductRangeSetID<BT>(
-          rs, *rootFileDB_, const_cast<EDProduct*>(product), checksumToIndex);
+          rs, *rangeSetWriter_, const_cast<EDProduct*>(product));
         val.product = product;
       }
     }
-    vpp->assign(keptprv.begin(), keptprv.end());
+    std::stable_sort(vpp->begin(), vpp->end());
+    vpp->erase(std::unique(vpp->begin(),
+                           vpp->end(),
+                           [](auto const& a, auto const& b) {
+                             return a.productID() == b.productID();
+                           }),
+               vpp->end());
+    for (auto const pid : dummyProvenance_) {
+      auto it = std::lower_bound(
+        vpp->begin(), vpp->end(), pid, [](auto const& pp, ProductID const id) {
+          return pp.productID() < id;
+        });
+      assert(it != vpp->end() && it->productID() == pid);
+      *it = ProductProvenance{pid, productstatus::dummyToPreventDoubleCount()};
+    }
     for (auto const& val : *vpp) {
       if (val.productStatus() == productstatus::uninitialized()) {
         throw Exception(errors::LogicError,
@@ -11,15 +11,19 @@
 #include "art_root_io/DummyProductCache.h"
 #include "art_root_io/FastCloningEnabled.h"
 #include "art_root_io/RootOutputTree.h"
+#include "art_root_io/detail/CompressionRules.h"
 #include "canvas/Persistency/Provenance/BranchDescription.h"
 #include "canvas/Persistency/Provenance/BranchType.h"
 #include "canvas/Persistency/Provenance/FileIndex.h"
+#include "canvas/Persistency/Provenance/ParentageID.h"
 #include "canvas/Persistency/Provenance/ProductID.h"
 #include "canvas/Persistency/Provenance/ProductProvenance.h"
 #include "canvas/Persistency/Provenance/fwd.h"
+#include "cetlib/exempt_ptr.h"
 #include "cetlib/sqlite/Connection.h"
 
 #include <array>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -33,6 +37,10 @@ class TTree;
 namespace art {
   class FileStatsCollector;
   class RootFileBlock;
+  class RootIOStatistics;
+  namespace detail {
+    class RangeSetWriter;
+  }
 
   struct OutputItem {
     ~OutputItem();
@@ -58,7 +66,15 @@ namespace art {
                             int splitLevel,
                             int basketSize,
                             DropMetaData dropMetaData,
-                            bool dropMetaDataForDroppedData);
+                            bool dropMetaDataForDroppedData,
+                            bool parallelBasketCompression = false,
+                            int writeCacheSize = 0,
+                            int rootFileDBPageSize = 0,
+                            unsigned basketOptimizationEntries = 0u,
+                            int64_t basketMemoryBudget = 0,
+                            int64_t clusterSize = 0,
+                            cet::exempt_ptr<detail::CompressionRules const>
+                              compressionRules = nullptr);
     RootOutputFile(RootOutputFile const&) = delete;
     RootOutputFile(RootOutputFile&&) = delete;
     RootOutputFile& operator=(RootOutputFile const&) = delete;
@@ -97,6 +113,26 @@ namespace art {
   private:
     template <BranchType>
     void fillBranches(Principal const&, std::vector<ProductProvenance>*);
+    // Returns false if the provenance of the product has already been
+    // kept for the current fill.
+    bool markKept(ProductID);
+    // The parents of a product with the given provenance that were
+    // produced in some process (and thus have provenance of their
+    // own), cached by parentage ID.  The descriptions of all parents
+    // are recorded for persistence on first use.
+    std::vector<ProductID> const& producedParents(BranchType,
+                                                  Principal const&,
+                                                  ProductProvenance const&);
+    // The run and subrun trees are fast cloned only from the first
+    // input file of the output file (see the implementation).
+    void fastCloneRunsAndSubRuns(RootFileBlock const&, bool firstInputFile);
+    void writeLayout();
+    void writeCompressionReport();
+    void keepAncestors(BranchType,
+                       Principal const&,
+                       ProductProvenance const&,
+                       bool keepParentProvenance,
+                       std::vector<ProductProvenance>& kept);
     template <BranchType BT>
     EDProduct const* getProduct(OutputHandle const&,
                                 RangeSet const& productRS,
@@ -114,7 +150,9 @@ namespace art {
     int const basketSize_;
     DropMetaData dropMetaData_;
     bool dropMetaDataForDroppedData_;
-    bool wasFastCloned_{false};
+    // For the current input file.
+    std::array<bool, NumBranchTypes> wasFastCloned_{};
+    bool firstInputFile_{true};
     std::unique_ptr<TFile> filePtr_;
     FileIndex fileIndex_;
     FileProperties fp_;
@@ -142,12 +180,36 @@ namespace art {
     std::array<ProductDescriptionsByID, NumBranchTypes> descriptionsToPersist_{
       {}};
     std::unique_ptr<cet::sqlite::Connection> rootFileDB_;
-    std::array<std::map<ProductID, OutputItem>, NumBranchTypes>
+    // Declared after rootFileDB_ so that its prepared statements are
+    // finalized before the connection is closed.
+    std::unique_ptr<detail::RangeSetWriter> rangeSetWriter_;
+    // The selected products, in the order in which they were selected.
+    // A deque, because the trees hold the addresses of the product
+    // pointers of the items.
+    std::array<std::deque<OutputItem>, NumBranchTypes>
       selectedOutputItemList_{{}};
+    // Whether the descriptions of the selected products of a branch
+    // type have been recorded in descriptionsToPersist_ since the
+    // selection last changed; they are recorded when the branch type
+    // is first filled.
+    std::array<bool, NumBranchTypes> selectionPersisted_{};
     DummyProductCache dummyProductCache_;
     unsigned subRunRSID_{-1u};
     unsigned runRSID_{-1u};
     std::chrono::steady_clock::time_point beginTime_;
+    // Provenance bookkeeping of fillBranches(), reused from one fill to
+    // the next.
+    unsigned long keptEpoch_{};
+    std::map<ProductID, unsigned long> keptEpochs_{};
+    std::vector<ProductID> dummyProvenance_{};
+    std::vector<ProductProvenance const*> ancestors_{};
+    std::array<std::map<ParentageID, std::vector<ProductID>>, NumBranchTypes>
+      producedParents_{};
+    std::vector<ProductID> uncachedParents_{};
+    // Set only if the RootIOStatistics service is configured.
+    RootIOStatistics* ioStatistics_{nullptr};
+    bool const optimizeLayout_;
+    cet::exempt_ptr<detail::CompressionRules const> compressionRules_;
   };
 
 } // namespace art
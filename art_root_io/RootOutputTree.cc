@@ -1,6 +1,7 @@
 #include "art_root_io/RootOutputTree.h"
 // vim: set sw=2:
 
+#include "art_root_io/RootIOStatistics.h"
 #include "canvas/Persistency/Common/EDProduct.h"
 #include "canvas/Persistency/Provenance/BranchDescription.h"
 #include "canvas/Utilities/Exception.h"
@@ -10,28 +11,59 @@
 #include "RtypesCore.h"
 #include "TBranch.h"
 #include "TClass.h"
-#include "TClassRef.h"
 #include "TFile.h"
 #include "TTreeCloner.h"
 
+#include <algorithm>
 #include <atomic>
 #include <limits>
+#include <optional>
 #include <string>
 
 namespace {
+  using WriteStats =
+    std::map<TBranch*, art::RootOutputTree::BranchWriteStats>;
+
   void
   fillBranches(std::vector<TBranch*> const& branches,
                bool const saveMemory,
-               int64_t const threshold)
+               int64_t const threshold,
+               WriteStats* writeStats)
   {
     for (auto b : branches) {
+      std::chrono::steady_clock::time_point start;
+      if (writeStats) {
+        start = std::chrono::steady_clock::now();
+      }
       auto bytesWritten = b->Fill();
+      if (writeStats) {
+        auto& stats = (*writeStats)[b];
+        ++stats.entries;
+        stats.bytes += std::max(bytesWritten, 0);
+        stats.time += std::chrono::steady_clock::now() - start;
+      }
       if (saveMemory and bytesWritten > threshold) {
         b->FlushBaskets();
         b->DropBaskets("all");
       }
     }
   }
+
+  // Fills every branch of the tree with TTree::Fill.  The entry is
+  // serialized sequentially, in branch order; with ROOT's implicit
+  // multi-threading enabled, the baskets that fill up are compressed
+  // and written as parallel tasks, which TTree::Fill waits for.
+  void
+  fillWholeTree(TTree* tree)
+  {
+    if (tree->GetNbranches() == 0) {
+      return;
+    }
+    if (tree->Fill() < 0) {
+      throw art::Exception{art::errors::FatalRootError}
+        << "Failed to write an entry of tree " << tree->GetName() << ".\n";
+    }
+  }
 }
 
 namespace art {
@@ -99,30 +131,102 @@ namespace art {
   void
   RootOutputTree::writeTree() const
   {
+    if (parallelBasketCompression_ && entriesPerCluster_ != 0) {
+      // Recorded only now: TTree::Fill would otherwise flush, and
+      // resize, the baskets on its own (see optimizeLayout()).
+      for (auto* t : {tree_.load(), metaTree_.load()}) {
+        t->SetAutoFlush(entriesPerCluster_);
+      }
+    }
     writeTTree(tree_.load());
     writeTTree(metaTree_.load());
   }
 
-  bool
-  RootOutputTree::fastCloneTree(cet::exempt_ptr<TTree const> intree)
+  void
+  RootOutputTree::recordStatistics()
+  {
+    recordStatistics_ = true;
+  }
+
+  void
+  RootOutputTree::reportStatistics(RootIOStatistics& statistics,
+                                   std::string const& fileName) const
+  {
+    // Fast-cloned branches are copied basket by basket and therefore
+    // do not appear in the statistics.
+    for (auto* tree : {tree_.load(), metaTree_.load()}) {
+      RootIOStatistics::TreeCounts counts{
+        fileName, tree->GetName(), RootIOStatistics::Direction::Write};
+      for (auto const& [br, stats] : writeStats_) {
+        if (br->GetTree() != tree) {
+          continue;
+        }
+        counts.branches.push_back(
+          {br->GetName(),
+           stats.entries,
+           static_cast<unsigned long long>(br->GetZipBytes("*")),
+           stats.bytes,
+           stats.time});
+      }
+      if (!counts.branches.empty()) {
+        statistics.record(std::move(counts));
+      }
+    }
+  }
+
+  void
+  RootOutputTree::setCompressionRules(
+    cet::exempt_ptr<detail::CompressionRules const> const rules)
+  {
+    if (rules->empty()) {
+      return;
+    }
+    compressionRules_ = rules;
+  }
+
+  void
+  RootOutputTree::reportCompression(
+    std::vector<detail::CompressionRules::Usage>& usage) const
+  {
+    for (auto const& [br, rule] : branchRules_) {
+      auto& u = usage[rule];
+      ++u.branches;
+      u.compressedBytes += br->GetZipBytes("*");
+      u.uncompressedBytes += br->GetTotBytes("*");
+      if (auto it = writeStats_.find(br); it != writeStats_.cend()) {
+        u.writeTime += it->second.time;
+      }
+    }
+  }
+
+  void
+  RootOutputTree::endFastCloning()
   {
+    wasFastCloned_ = false;
     unclonedReadBranches_.clear();
     unclonedReadBranchNames_.clear();
+  }
+
+  bool
+  RootOutputTree::fastCloneTree(cet::exempt_ptr<TTree const> intree)
+  {
+    endFastCloning();
 
     if (intree->GetEntries() != 0) {
-      auto event_tree = const_cast<TTree*>(intree.get());
+      auto input_tree = const_cast<TTree*>(intree.get());
 
-      // Remove EventAuxiliary branches from fast cloning so we can
-      // update the stored ProcessHistoryID.
-      auto branches = event_tree->GetListOfBranches();
-      auto aux_branch = event_tree->GetBranch("EventAuxiliary");
+      // Remove the auxiliary branch from fast cloning so we can
+      // update the stored ProcessHistoryID (and, for runs and subruns,
+      // the RangeSet ID).
+      auto branches = input_tree->GetListOfBranches();
+      auto aux_branch = input_tree->GetBranch(auxBranch_->GetName());
       assert(aux_branch);
       auto const aux_index = branches->IndexOf(aux_branch);
       assert(aux_index >= 0);
       branches->RemoveAt(aux_index);
       branches->Compress();
 
-      TTreeCloner cloner(event_tree,
+      TTreeCloner cloner(input_tree,
                          tree_.load(),
                          "",
                          TTreeCloner::kIgnoreMissingTopLevel |
@@ -166,16 +270,101 @@ namespace art {
   void
   RootOutputTree::fillTree()
   {
-    fillBranches(metaBranches_, false, saveMemoryObjectThreshold_);
+    auto* const stats = recordStatistics_ ? &writeStats_ : nullptr;
     bool const saveMemory{saveMemoryObjectThreshold_ > -1};
-    fillBranches(producedBranches_, saveMemory, saveMemoryObjectThreshold_);
-    if (wasFastCloned_.load()) {
-      fillBranches(
-        unclonedReadBranches_, saveMemory, saveMemoryObjectThreshold_);
+    // TTree::Fill fills all branches of a tree, and its bytes are not
+    // attributed to branches: the trees are filled branch by branch
+    // while some of their branches are fast cloned, when large
+    // objects are flushed as they are written, and when per-branch
+    // statistics are recorded.
+    if (parallelBasketCompression_ && !wasFastCloned_.load() &&
+        !saveMemory && stats == nullptr) {
+      fillWholeTree(metaTree_.load());
+      fillWholeTree(tree_.load());
     } else {
-      fillBranches(readBranches_, saveMemory, saveMemoryObjectThreshold_);
+      fillBranches(metaBranches_, false, saveMemoryObjectThreshold_, stats);
+      fillBranches(
+        producedBranches_, saveMemory, saveMemoryObjectThreshold_, stats);
+      if (wasFastCloned_.load()) {
+        fillBranches(
+          unclonedReadBranches_, saveMemory, saveMemoryObjectThreshold_, stats);
+      } else {
+        fillBranches(
+          readBranches_, saveMemory, saveMemoryObjectThreshold_, stats);
+      }
     }
     ++nEntries_;
+    if (layoutEntries_ == 0u || wasFastCloned_.load()) {
+      return;
+    }
+    if (entriesPerCluster_ == 0) {
+      if (nEntries_.load() == static_cast<int>(layoutEntries_)) {
+        optimizeLayout();
+      }
+    } else if (nEntries_.load() == nextClusterEnd_) {
+      endCluster();
+    }
+  }
+
+  void
+  RootOutputTree::setLayoutOptimization(unsigned const entries,
+                                        Long64_t const basketMemory,
+                                        Long64_t const clusterSize)
+  {
+    layoutEntries_ = entries;
+    basketMemory_ = basketMemory;
+    clusterSize_ = clusterSize;
+  }
+
+  void
+  RootOutputTree::optimizeLayout()
+  {
+    auto const nEntries = static_cast<Long64_t>(nEntries_.load());
+    TTree* tree = tree_.load();
+    // TTree::OptimizeBaskets and TTree::GetTotBytes count only the
+    // baskets already written: flush those of the learning window.
+    for (auto* t : {tree, metaTree_.load()}) {
+      if (t->GetNbranches() != 0) {
+        t->SetEntries(-1);
+        // The cluster is marked by endCluster(), below.
+        t->FlushBaskets(false);
+        t->OptimizeBaskets(basketMemory_, 1.1, "");
+      }
+    }
+    if (clusterSize_ > 0) {
+      entriesPerCluster_ = clusterSize_;
+    } else if (clusterSize_ < 0) {
+      auto const bytesPerEntry =
+        std::max(tree->GetTotBytes() / nEntries, Long64_t{1});
+      entriesPerCluster_ = std::max(-clusterSize_ / bytesPerEntry, Long64_t{1});
+    } else {
+      entriesPerCluster_ = nEntries;
+    }
+    endCluster();
+    if (parallelBasketCompression_) {
+      // The clusters are ended by fillTree(); the trees filled with
+      // TTree::Fill record their cluster size only when written.
+      return;
+    }
+    for (auto* t : {tree, metaTree_.load()}) {
+      t->SetAutoFlush(entriesPerCluster_);
+    }
+  }
+
+  void
+  RootOutputTree::endCluster()
+  {
+    // The branches are filled individually, so ROOT's own automatic
+    // flushing, which is done by TTree::Fill, does not apply.
+    for (auto* t : {tree_.load(), metaTree_.load()}) {
+      if (t->GetNbranches() == 0) {
+        continue;
+      }
+      t->SetEntries(-1);
+      t->FlushBaskets(false);
+      t->MarkEventCluster();
+    }
+    nextClusterEnd_ = nEntries_.load() + entriesPerCluster_;
   }
 
   void
@@ -195,7 +384,10 @@ namespace art {
   RootOutputTree::addOutputBranch(BranchDescription const& bd,
                                   void const*& pProd)
   {
-    TClassRef cls = TClass::GetClass(bd.wrappedName().c_str());
+    auto& cls = wrappedClasses_[bd.productID()];
+    if (cls == nullptr) {
+      cls = TClass::GetClass(bd.wrappedName().c_str());
+    }
     if (TBranch* br = tree_.load()->GetBranch(bd.branchName().c_str())) {
       // Already have this branch, possibly update the branch address.
       if (pProd == nullptr) {
@@ -242,7 +434,14 @@ namespace art {
     pProd = nullptr;
     delete prod;
 
-    if (bd.compression() != BranchDescription::invalidCompression) {
+    std::optional<std::size_t> rule;
+    if (compressionRules_) {
+      rule = compressionRules_->match(bd);
+    }
+    if (rule) {
+      branch->SetCompressionSettings(compressionRules_->settings(*rule));
+      branchRules_.emplace(branch, *rule);
+    } else if (bd.compression() != BranchDescription::invalidCompression) {
       branch->SetCompressionSettings(bd.compression());
     }
 
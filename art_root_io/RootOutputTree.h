@@ -5,23 +5,37 @@
 // Used by ROOT output modules.
 
 #include "canvas/Persistency/Provenance/BranchType.h"
+#include "canvas/Persistency/Provenance/ProductID.h"
 #include "canvas/Persistency/Provenance/ProductProvenance.h"
 #include "canvas/Persistency/Provenance/fwd.h"
 #include "cetlib/container_algorithms.h"
 #include "cetlib/exempt_ptr.h"
 
+#include "art_root_io/detail/CompressionRules.h"
+
 #include "TTree.h"
 
 #include <atomic>
+#include <chrono>
+#include <map>
 #include <string>
 #include <vector>
 
 class TFile;
 class TBranch;
+class TClass;
 
 namespace art {
+  class RootIOStatistics;
+
   class RootOutputTree {
   public:
+    struct BranchWriteStats {
+      unsigned long long entries{};
+      unsigned long long bytes{};
+      std::chrono::nanoseconds time{};
+    };
+
     static TTree* makeTTree(TFile*, std::string const& name, int splitLevel);
     // This routine MAY THROW if art converts a ROOT error message to
     // an exception.
@@ -36,7 +50,8 @@ namespace art {
                    int const bufSize,
                    int const splitLevel,
                    int64_t const treeMaxVirtualSize,
-                   int64_t const saveMemoryObjectThreshold)
+                   int64_t const saveMemoryObjectThreshold,
+                   bool const parallelBasketCompression = false)
       : filePtr_{filePtr}
       , tree_{makeTTree(filePtr.get(),
                         BranchTypeToProductTreeName(branchType),
@@ -47,10 +62,19 @@ namespace art {
       , basketSize_{bufSize}
       , splitLevel_{splitLevel}
       , saveMemoryObjectThreshold_{saveMemoryObjectThreshold}
+      , parallelBasketCompression_{parallelBasketCompression}
     {
       if (treeMaxVirtualSize >= 0) {
         tree_.load()->SetMaxVirtualSize(treeMaxVirtualSize);
       }
+      if (parallelBasketCompression_) {
+        for (auto* t : {tree_.load(), metaTree_.load()}) {
+          // The trees are filled with TTree::Fill (see fillTree()),
+          // which must neither flush nor resize the baskets itself.
+          t->SetAutoFlush(0);
+          t->SetImplicitMT(true);
+        }
+      }
       auxBranch_ = tree_.load()->Branch(
         BranchTypeToAuxiliaryBranchName(branchType).c_str(), &pAux, bufSize, 0);
       delete pAux;
@@ -71,9 +95,46 @@ namespace art {
     void resetOutputBranchAddress(BranchDescription const&);
     void addOutputBranch(BranchDescription const&, void const*& pProd);
     bool checkSplitLevelAndBasketSize(cet::exempt_ptr<TTree const>) const;
+    // Fast cloning applies to one input file at a time.  After a
+    // successful fastCloneTree(), each fillTree() fills only the
+    // branches that were not cloned, for the next of the cloned
+    // entries; endFastCloning() makes fillTree() fill all branches.
     bool fastCloneTree(cet::exempt_ptr<TTree const>);
+    void endFastCloning();
     void fillTree();
     void writeTree() const;
+    // Per-branch write statistics are gathered by fillTree() only
+    // after recordStatistics() has been called.
+    void recordStatistics();
+    // After 'entries' entries, resize the baskets of the trees in
+    // proportion to the sizes of their branches so far, within
+    // 'basketMemory' bytes (see TTree::OptimizeBaskets).  From then on,
+    // the baskets are flushed in clusters of 'clusterSize' entries if
+    // it is positive, or of about -'clusterSize' uncompressed bytes if
+    // it is negative.  Does nothing for fast-cloned trees, whose
+    // layout is that of the input.
+    void setLayoutOptimization(unsigned entries,
+                               Long64_t basketMemory,
+                               Long64_t clusterSize);
+    void reportStatistics(RootIOStatistics& statistics,
+                          std::string const& fileName) const;
+    // The compression of each product branch added from now on is
+    // given by the first matching rule, if any, instead of by its
+    // BranchDescription.
+    void setCompressionRules(
+      cet::exempt_ptr<detail::CompressionRules const> rules);
+    // Adds the totals of the branches written with each rule to
+    // 'usage', which has one element per rule.  The sizes are those of
+    // the branches; the write times are added only if the per-branch
+    // statistics are recorded.
+    void reportCompression(
+      std::vector<detail::CompressionRules::Usage>& usage) const;
+    // The rule applied to each product branch.
+    std::map<TBranch*, std::size_t> const&
+    branchRules() const
+    {
+      return branchRules_;
+    }
     TTree*
     tree() const
     {
@@ -105,6 +166,10 @@ namespace art {
       return cet::binary_search_all(unclonedReadBranchNames_, branchName);
     }
 
+  private: // MEMBER FUNCTIONS
+    void optimizeLayout();
+    void endCluster();
+
   private: // MEMBER DATA
     cet::exempt_ptr<TFile> filePtr_;
     std::atomic<TTree*> tree_;
@@ -120,7 +185,25 @@ namespace art {
     int const basketSize_;
     int const splitLevel_;
     int64_t const saveMemoryObjectThreshold_;
+    // If true, fillTree() fills whole trees with TTree::Fill when it
+    // can, so that full baskets are compressed and written by tasks on
+    // ROOT's implicit-MT task arena.
+    bool const parallelBasketCompression_;
     std::atomic<int> nEntries_{0};
+    // Dictionaries of the wrapped product types.  addOutputBranch() is
+    // called for every selected product each time the selection is
+    // updated; the lookup is done only the first time.
+    std::map<ProductID, TClass*> wrappedClasses_{};
+    bool recordStatistics_{false};
+    unsigned layoutEntries_{};
+    Long64_t basketMemory_{};
+    Long64_t clusterSize_{};
+    // Zero until the layout has been optimized.
+    Long64_t entriesPerCluster_{};
+    Long64_t nextClusterEnd_{};
+    std::map<TBranch*, BranchWriteStats> writeStats_{};
+    cet::exempt_ptr<detail::CompressionRules const> compressionRules_{};
+    std::map<TBranch*, std::size_t> branchRules_{};
   };
 } // namespace art
 
@@ -20,18 +20,24 @@
 #include "art_root_io/FastCloningEnabled.h"
 #include "art_root_io/RootFileBlock.h"
 #include "art_root_io/RootOutputFile.h"
+#include "art_root_io/detail/CompressionRules.h"
 #include "art_root_io/detail/rootOutputConfigurationTools.h"
 #include "art_root_io/setup.h"
 #include "canvas/Persistency/Provenance/ProductTables.h"
 #include "canvas/Utilities/Exception.h"
+#include "cetlib/exempt_ptr.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "fhiclcpp/types/Atom.h"
 #include "fhiclcpp/types/ConfigurationTable.h"
 #include "fhiclcpp/types/OptionalAtom.h"
+#include "fhiclcpp/types/OptionalSequence.h"
 #include "fhiclcpp/types/Table.h"
 #include "fhiclcpp/types/TableFragment.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
+#include "TROOT.h"
+
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -104,11 +110,93 @@ namespace art {
       OptionalAtom<bool> fastCloning{Name("fastCloning")};
       Atom<string> tmpDir{Name("tmpDir"), default_tmpDir};
       Atom<int> compressionLevel{Name("compressionLevel"), 7};
+
+      struct CompressionRule {
+        Atom<string> pattern{
+          Name("pattern"),
+          Comment("A product specification as in 'outputCommands':\n"
+                  "'<friendly class>_<module label>_<instance>_<process>',\n"
+                  "with the wildcards '*' and '?'.  Trailing fields that\n"
+                  "are left out match anything.")};
+        Atom<string> algorithm{
+          Name("algorithm"),
+          Comment("One of 'ZLIB', 'LZMA', 'LZ4' or 'ZSTD'.")};
+        Atom<int> level{Name("level"), Comment("From 0 to 9.")};
+      };
+      fhicl::OptionalSequence<fhicl::Table<CompressionRule>> compressionRules{
+        Name("compressionRules"),
+        Comment(
+          "The product branches that match the pattern of a rule are\n"
+          "compressed with its algorithm and level; the first matching\n"
+          "rule applies.  Other branches are compressed according to\n"
+          "'compressionLevel'.  For each rule, the number of branches\n"
+          "and their sizes are recorded in the RootFileDB table\n"
+          "'CompressionRules', and the rule applied to each branch in the\n"
+          "table 'BranchCompression'.  The time spent writing the branches\n"
+          "is recorded too if the RootIOStatistics service is configured.\n"
+          "Fast cloning is disabled if any rule is configured.")};
       Atom<int64_t> saveMemoryObjectThreshold{Name("saveMemoryObjectThreshold"),
                                               -1l};
       Atom<int64_t> treeMaxVirtualSize{Name("treeMaxVirtualSize"), -1};
       Atom<int> splitLevel{Name("splitLevel"), 1};
       Atom<int> basketSize{Name("basketSize"), 16384};
+      Atom<bool> parallelBasketCompression{
+        Name("parallelBasketCompression"),
+        Comment(
+          "If 'parallelBasketCompression' is 'true', the trees are filled\n"
+          "with TTree::Fill: products are still serialized sequentially, but\n"
+          "full baskets are compressed and written by ROOT's implicit\n"
+          "multi-threading pool, which is enabled with the number of threads\n"
+          "configured for the art job if it is not already on.  The stored\n"
+          "entries and basket contents do not depend on the number of\n"
+          "threads; only the order in which the baskets of different\n"
+          "branches are placed in the file may vary.  Trees being fast\n"
+          "cloned, and all trees if 'saveMemoryObjectThreshold' is set or\n"
+          "the RootIOStatistics service is configured, are filled branch by\n"
+          "branch, without parallel compression."),
+        false};
+      Atom<int> writeCacheSize{
+        Name("writeCacheSize"),
+        Comment(
+          "If 'writeCacheSize' is non-zero, the baskets and keys written to\n"
+          "the output file are accumulated in a write cache of that many\n"
+          "bytes and written to storage in large sequential chunks instead\n"
+          "of one write per basket."),
+        0};
+      Atom<unsigned> basketOptimizationEvents{
+        Name("basketOptimizationEvents"),
+        Comment(
+          "If 'basketOptimizationEvents' is non-zero, the sizes of the\n"
+          "branches of each tree are measured over that many entries.  The\n"
+          "basket sizes are then set in proportion to them, within\n"
+          "'basketMemoryBudget' bytes per tree, and the remaining entries\n"
+          "are written in clusters of 'clusterSize'.  The chosen basket and\n"
+          "cluster sizes are recorded in the RootFileDB tables\n"
+          "'BasketLayout' and 'ClusterLayout'.  Fast-cloned trees keep the\n"
+          "layout of the input file."),
+        0u};
+      Atom<int64_t> basketMemoryBudget{
+        Name("basketMemoryBudget"),
+        Comment("The total size of the baskets of a tree, in bytes, when\n"
+                "'basketOptimizationEvents' is non-zero."),
+        10000000};
+      Atom<int64_t> clusterSize{
+        Name("clusterSize"),
+        Comment(
+          "If positive, the number of entries per cluster; if negative, the\n"
+          "approximate number of uncompressed bytes per cluster; if zero,\n"
+          "clusters have 'basketOptimizationEvents' entries.  Used only if\n"
+          "'basketOptimizationEvents' is non-zero."),
+        -30000000};
+      Atom<int> rootFileDBPageSize{
+        Name("rootFileDBPageSize"),
+        Comment(
+          "If 'rootFileDBPageSize' is non-zero, the RootFileDB database is\n"
+          "stored as separate keys of that many bytes instead of as a\n"
+          "single key.  Readers then load only the pages they need.  Files\n"
+          "written this way cannot be read by releases that predate the\n"
+          "option.  It may not be negative."),
+        0};
       Atom<bool> dropMetaDataForDroppedData{Name("dropMetaDataForDroppedData"),
                                             false};
       Atom<string> dropMetaData{Name("dropMetaData"), "NONE"};
@@ -217,6 +305,13 @@ namespace art {
     int64_t const treeMaxVirtualSize_;
     int const splitLevel_;
     int const basketSize_;
+    bool const parallelBasketCompression_;
+    int const writeCacheSize_;
+    int const rootFileDBPageSize_;
+    unsigned const basketOptimizationEvents_;
+    int64_t const basketMemoryBudget_;
+    int64_t const clusterSize_;
+    detail::CompressionRules compressionRules_{};
     DropMetaData dropMetaData_;
     bool dropMetaDataForDroppedData_;
     FastCloningEnabled fastCloningEnabled_{};
@@ -246,6 +341,12 @@ namespace art {
     , treeMaxVirtualSize_{config().treeMaxVirtualSize()}
     , splitLevel_{config().splitLevel()}
     , basketSize_{config().basketSize()}
+    , parallelBasketCompression_{config().parallelBasketCompression()}
+    , writeCacheSize_{config().writeCacheSize()}
+    , rootFileDBPageSize_{config().rootFileDBPageSize()}
+    , basketOptimizationEvents_{config().basketOptimizationEvents()}
+    , basketMemoryBudget_{config().basketMemoryBudget()}
+    , clusterSize_{config().clusterSize()}
     , dropMetaData_{config().dropMetaData()}
     , dropMetaDataForDroppedData_{config().dropMetaDataForDroppedData()}
     , writeParameterSets_{config().writeParameterSets()}
@@ -255,9 +356,17 @@ namespace art {
     bool const check_filename = config.get_PSet().has_key("fileProperties") and
                                 config().safeFileName().checkFileName();
     detail::validateFileNamePattern(check_filename, filePattern_);
+    if (rootFileDBPageSize_ < 0) {
+      throw Exception(errors::Configuration)
+        << "The RootFileDB page size of output module " << moduleLabel_
+        << ", " << rootFileDBPageSize_ << ", is negative.\n";
+    }
 
     // Setup the streamers and error handlers.
     root::setup();
+    if (parallelBasketCompression_ && !ROOT::IsImplicitMTEnabled()) {
+      ROOT::EnableImplicitMT(Globals::instance()->nthreads());
+    }
 
     bool const dropAllEventsSet{config().dropAllEvents(dropAllEvents_)};
     dropAllEvents_ = detail::shouldDropEvents(
@@ -271,6 +380,23 @@ namespace art {
     bool const fastCloningSet{config().fastCloning(fastCloningEnabled)};
     fastCloningEnabled_ = shouldFastClone(
       fastCloningSet, fastCloningEnabled, wantAllEvents(), fileProperties_);
+    if (dropAllEvents_) {
+      // Cloned entries would be written even though the events (and
+      // possibly the subruns) they belong to are dropped.
+      fastCloningEnabled_.disable("All events are dropped.");
+    }
+
+    std::vector<Config::CompressionRule> rules;
+    if (config().compressionRules(rules)) {
+      for (auto const& rule : rules) {
+        compressionRules_.add(rule.pattern(), rule.algorithm(), rule.level());
+      }
+    }
+    if (!compressionRules_.empty()) {
+      // Fast-cloned baskets are copied as they are compressed in the
+      // input file.
+      fastCloningEnabled_.disable("Compression rules are configured.");
+    }
 
     if (auto const n = Globals::instance()->nschedules(); n > 1) {
       std::ostringstream oss;
@@ -571,6 +697,7 @@ namespace art {
         << "Attempt to open output file before input file. "
         << "Please report this to the core framework developers.\n";
     }
+    auto const compressionRules = cet::make_exempt_ptr(&compressionRules_);
     rootOutputFile_ = make_unique<RootOutputFile>(this,
                                                   fileNameAtOpen(),
                                                   fileProperties_,
@@ -580,7 +707,14 @@ namespace art {
                                                   splitLevel_,
                                                   basketSize_,
                                                   dropMetaData_,
-                                                  dropMetaDataForDroppedData_);
+                                                  dropMetaDataForDroppedData_,
+                                                  parallelBasketCompression_,
+                                                  writeCacheSize_,
+                                                  rootFileDBPageSize_,
+                                                  basketOptimizationEvents_,
+                                                  basketMemoryBudget_,
+                                                  clusterSize_,
+                                                  compressionRules);
     fstats_.recordFileOpen();
     detail::logFileAction("Opened output file with pattern ", filePattern_);
   }
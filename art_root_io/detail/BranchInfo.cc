@@ -0,0 +1,81 @@
+#include "art_root_io/Inputfwd.h"
+// vim: set sw=2 expandtab :
+
+#include "canvas/Persistency/Common/EDProduct.h"
+#include "canvas/Persistency/Provenance/BranchDescription.h"
+
+#include "TBranch.h"
+#include "TClass.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+namespace art::input {
+
+  BranchInfo::BranchInfo(BranchDescription const& prod, TBranch* const branch)
+    : branchDescription_{prod}, productBranch_{branch}
+  {
+    if (branch == nullptr) {
+      return;
+    }
+    wrappedClass_ = TClass::GetClass(prod.wrappedName().c_str());
+    if (wrappedClass_ != nullptr) {
+      newWrapped_ = wrappedClass_->GetNew();
+    }
+  }
+
+  EDProduct*
+  BranchInfo::newProduct() const
+  {
+    // Use the allocator of the dictionary directly when it has one;
+    // TClass::New() would only forward to it.
+    void* p = newWrapped_ != nullptr ? newWrapped_(nullptr) :
+                                       wrappedClass_->New();
+    return static_cast<EDProduct*>(p);
+  }
+
+  void
+  BranchInfo::setActive(bool const active) const
+  {
+    if (productBranch_ == nullptr || active == active_) {
+      return;
+    }
+    auto* tree = productBranch_->GetTree();
+    // Product branch names end with '.', so the pattern matches only
+    // the branch itself and its sub-branches.
+    auto const pattern = std::string{productBranch_->GetName()} + '*';
+    tree->SetBranchStatus(pattern.c_str(), active);
+    if (active) {
+      tree->AddBranchToCache(productBranch_, kTRUE);
+    } else {
+      tree->DropBranchFromCache(productBranch_, kTRUE);
+    }
+    active_ = active;
+  }
+
+  void
+  BranchMap::emplace(ProductID const pid, BranchInfo&& info)
+  {
+    auto const it = std::lower_bound(ids_.cbegin(), ids_.cend(), pid);
+    if (it != ids_.cend() && *it == pid) {
+      return;
+    }
+    auto const i = std::distance(ids_.cbegin(), it);
+    ids_.insert(it, pid);
+    positions_.insert(positions_.cbegin() + i, branches_.size());
+    branches_.emplace_back(pid, std::move(info));
+  }
+
+  BranchMap::const_iterator
+  BranchMap::find(ProductID const pid) const
+  {
+    auto const it = std::lower_bound(ids_.cbegin(), ids_.cend(), pid);
+    if (it == ids_.cend() || *it != pid) {
+      return end();
+    }
+    return begin() + positions_[std::distance(ids_.cbegin(), it)];
+  }
+
+} // namespace art::input
@@ -0,0 +1,128 @@
+#include "art_root_io/detail/CompressionRules.h"
+// vim: set sw=2 expandtab :
+
+#include "canvas/Persistency/Provenance/BranchDescription.h"
+#include "canvas/Utilities/Exception.h"
+
+#include "Compression.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace {
+
+  using Algorithm = ROOT::RCompressionSetting::EAlgorithm::EValues;
+
+  std::array<std::pair<char const*, Algorithm>, 4> const algorithms{
+    {{"ZLIB", ROOT::RCompressionSetting::EAlgorithm::kZLIB},
+     {"LZMA", ROOT::RCompressionSetting::EAlgorithm::kLZMA},
+     {"LZ4", ROOT::RCompressionSetting::EAlgorithm::kLZ4},
+     {"ZSTD", ROOT::RCompressionSetting::EAlgorithm::kZSTD}}};
+
+  std::vector<std::string>
+  split(std::string const& pattern)
+  {
+    std::vector<std::string> result;
+    std::string::size_type begin{};
+    for (auto end = pattern.find('_'); end != std::string::npos;
+         begin = end + 1, end = pattern.find('_', begin)) {
+      result.push_back(pattern.substr(begin, end - begin));
+    }
+    result.push_back(pattern.substr(begin));
+    return result;
+  }
+
+  // Matches 'text' against 'pattern', in which '*' matches any
+  // sequence of characters and '?' any single character.
+  bool
+  glob_match(std::string const& pattern, std::string const& text)
+  {
+    std::size_t p{}, t{};
+    auto star = std::string::npos;
+    std::size_t resume{};
+    while (t != text.size()) {
+      if (p != pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+        ++p;
+        ++t;
+      } else if (p != pattern.size() && pattern[p] == '*') {
+        star = p++;
+        resume = t;
+      } else if (star != std::string::npos) {
+        p = star + 1;
+        t = ++resume;
+      } else {
+        return false;
+      }
+    }
+    while (p != pattern.size() && pattern[p] == '*') {
+      ++p;
+    }
+    return p == pattern.size();
+  }
+
+} // namespace
+
+namespace art::detail {
+
+  void
+  CompressionRules::add(std::string const& pattern,
+                        std::string const& algorithm,
+                        int const level)
+  {
+    auto fields = split(pattern);
+    if (fields.size() > 4) {
+      throw Exception{errors::Configuration}
+        << "The compression rule pattern '" << pattern
+        << "' has more than the four fields\n"
+        << "<friendly class name>_<module label>_<instance name>_<process "
+           "name>.\n";
+    }
+    fields.resize(4, "*");
+    auto const it =
+      std::find_if(begin(algorithms), end(algorithms), [&algorithm](auto p) {
+        return algorithm == p.first;
+      });
+    if (it == end(algorithms)) {
+      throw Exception{errors::Configuration}
+        << "The compression algorithm '" << algorithm << "' of rule '"
+        << pattern << "' is not one of 'ZLIB', 'LZMA', 'LZ4' or 'ZSTD'.\n";
+    }
+    if (level < 0 || level > 9) {
+      throw Exception{errors::Configuration}
+        << "The compression level " << level << " of rule '" << pattern
+        << "' is not between 0 and 9.\n";
+    }
+    rules_.push_back({{pattern, algorithm, level},
+                      std::move(fields),
+                      ROOT::CompressionSettings(it->second, level)});
+  }
+
+  std::optional<std::size_t>
+  CompressionRules::match(BranchDescription const& bd) const
+  {
+    return match(bd.friendlyClassName(),
+                 bd.moduleLabel(),
+                 bd.productInstanceName(),
+                 bd.processName());
+  }
+
+  std::optional<std::size_t>
+  CompressionRules::match(std::string const& friendlyClassName,
+                          std::string const& moduleLabel,
+                          std::string const& instanceName,
+                          std::string const& processName) const
+  {
+    for (std::size_t i = 0; i != rules_.size(); ++i) {
+      auto const& fields = rules_[i].fields;
+      if (glob_match(fields[0], friendlyClassName) &&
+          glob_match(fields[1], moduleLabel) &&
+          glob_match(fields[2], instanceName) &&
+          glob_match(fields[3], processName)) {
+        return i;
+      }
+    }
+    return std::nullopt;
+  }
+
+} // namespace art::detail
@@ -0,0 +1,99 @@
+#ifndef art_root_io_detail_CompressionRules_h
+#define art_root_io_detail_CompressionRules_h
+// vim: set sw=2 expandtab :
+
+// ======================================================================
+// CompressionRules
+//
+// An ordered list of rules, each assigning a ROOT compression
+// algorithm and level to the branches of the products that match its
+// pattern.  A pattern has the form of the product specifications of
+// 'outputCommands',
+//
+//   <friendly class name>_<module label>_<instance name>_<process name>
+//
+// where each field may use the wildcards '*' and '?', and trailing
+// fields that are left out match anything.  The first matching rule
+// applies.
+// ======================================================================
+
+#include "canvas/Persistency/Provenance/fwd.h"
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace art::detail {
+
+  class CompressionRules {
+  public:
+    struct Rule {
+      std::string pattern;
+      std::string algorithm;
+      int level;
+    };
+
+    // Per-rule totals over the branches written with it.
+    struct Usage {
+      unsigned long long branches{};
+      unsigned long long compressedBytes{};
+      unsigned long long uncompressedBytes{};
+      std::chrono::nanoseconds writeTime{};
+    };
+
+    // Throws an art::Exception (errors::Configuration) if the pattern
+    // has more than four fields, if the algorithm is not one of
+    // 'ZLIB', 'LZMA', 'LZ4' or 'ZSTD', or if the level is not between
+    // 0 and 9.
+    void add(std::string const& pattern,
+             std::string const& algorithm,
+             int level);
+
+    bool
+    empty() const
+    {
+      return rules_.empty();
+    }
+    std::size_t
+    size() const
+    {
+      return rules_.size();
+    }
+    Rule const&
+    operator[](std::size_t const i) const
+    {
+      return rules_[i].rule;
+    }
+
+    // The index of the first rule that matches the product, if any.
+    std::optional<std::size_t> match(BranchDescription const& bd) const;
+    std::optional<std::size_t> match(std::string const& friendlyClassName,
+                                     std::string const& moduleLabel,
+                                     std::string const& instanceName,
+                                     std::string const& processName) const;
+
+    // The ROOT compression settings (algorithm * 100 + level) of rule i.
+    int
+    settings(std::size_t const i) const
+    {
+      return rules_[i].settings;
+    }
+
+  private:
+    struct Entry {
+      Rule rule;
+      std::vector<std::string> fields;
+      int settings;
+    };
+    std::vector<Entry> rules_{};
+  };
+
+} // namespace art::detail
+
+#endif /* art_root_io_detail_CompressionRules_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,144 @@
+#include "art_root_io/detail/EventIDSet.h"
+// vim: set sw=2 expandtab :
+
+#include "canvas/Persistency/Provenance/FileIndex.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+  // A subrun is kept as a bitmap as long as that takes no more than
+  // this many bits per event.
+  constexpr std::uint64_t maxBitsPerEvent{64};
+}
+
+namespace art::detail {
+
+  void
+  EventIDSet::reserve(FileIndex const& fileIndex)
+  {
+    // The entries of a sorted index are grouped by subrun; an unsorted
+    // one merely results in more, smaller reservations.
+    SubRunID current{};
+    EventNumber_t first{};
+    EventNumber_t last{};
+    std::size_t nEvents{};
+    auto flush = [this, &current, &first, &last, &nEvents] {
+      if (nEvents != 0) {
+        subRunEvents(current).reserve(first, last, nEvents);
+      }
+      nEvents = 0;
+    };
+    for (auto const& element : fileIndex) {
+      if (element.getEntryType() != FileIndex::kEvent) {
+        continue;
+      }
+      auto const& id = element.eventID;
+      if (nEvents == 0 || id.subRunID() != current) {
+        flush();
+        current = id.subRunID();
+        first = last = id.event();
+      }
+      first = std::min(first, id.event());
+      last = std::max(last, id.event());
+      ++nEvents;
+    }
+    flush();
+  }
+
+  bool
+  EventIDSet::insert(EventID const& id)
+  {
+    return subRunEvents(id.subRunID()).insert(id.event());
+  }
+
+  void
+  EventIDSet::clear()
+  {
+    subRuns_.clear();
+    lastSubRun_ = SubRunID{};
+    lastEvents_ = nullptr;
+  }
+
+  EventIDSet::SubRunEvents&
+  EventIDSet::subRunEvents(SubRunID const& id)
+  {
+    if (lastEvents_ == nullptr || id != lastSubRun_) {
+      lastEvents_ = &subRuns_[id];
+      lastSubRun_ = id;
+    }
+    return *lastEvents_;
+  }
+
+  void
+  EventIDSet::SubRunEvents::reserve(EventNumber_t const first,
+                                    EventNumber_t const last,
+                                    std::size_t const nEvents)
+  {
+    nEvents_ += nEvents;
+    if (isSparse_) {
+      sparse_.reserve(nEvents_);
+      return;
+    }
+    std::uint64_t lo{first};
+    std::uint64_t hi{last};
+    if (!dense_.empty()) {
+      lo = std::min<std::uint64_t>(lo, first_);
+      hi = std::max<std::uint64_t>(hi, first_ + dense_.size() - 1);
+    }
+    if (hi - lo + 1 > maxBitsPerEvent * nEvents_) {
+      makeSparse();
+      sparse_.reserve(nEvents_);
+      return;
+    }
+    if (dense_.empty()) {
+      first_ = static_cast<EventNumber_t>(lo);
+    } else if (lo < first_) {
+      dense_.insert(dense_.begin(), first_ - lo, false);
+      first_ = static_cast<EventNumber_t>(lo);
+    }
+    dense_.resize(hi - lo + 1, false);
+  }
+
+  bool
+  EventIDSet::SubRunEvents::insert(EventNumber_t const event)
+  {
+    if (!isSparse_) {
+      if (dense_.empty() || event < first_ ||
+          event - first_ >= dense_.size()) {
+        // An event that was not reserved.
+        reserve(event, event, 1);
+        if (isSparse_) {
+          return insert(event);
+        }
+      }
+      auto bit = dense_[event - first_];
+      if (bit) {
+        return false;
+      }
+      bit = true;
+      return true;
+    }
+    // Events are usually inserted in increasing order, so this is
+    // normally an append.
+    auto const it = std::lower_bound(sparse_.begin(), sparse_.end(), event);
+    if (it != sparse_.end() && *it == event) {
+      return false;
+    }
+    sparse_.insert(it, event);
+    return true;
+  }
+
+  void
+  EventIDSet::SubRunEvents::makeSparse()
+  {
+    for (std::size_t i = 0, n = dense_.size(); i != n; ++i) {
+      if (dense_[i]) {
+        sparse_.push_back(static_cast<EventNumber_t>(first_ + i));
+      }
+    }
+    dense_ = std::vector<bool>{};
+    isSparse_ = true;
+  }
+
+} // namespace art::detail
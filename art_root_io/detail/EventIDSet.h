@@ -0,0 +1,72 @@
+#ifndef art_root_io_detail_EventIDSet_h
+#define art_root_io_detail_EventIDSet_h
+
+// ======================================================================
+// EventIDSet
+//
+// A compact set of event IDs, used by DuplicateChecker.  The event
+// numbers of each subrun are kept as a bitmap over the range of event
+// numbers that reserve() was told about, which costs about one bit per
+// event for the usual densely numbered subruns.  A subrun whose event
+// numbers are too sparse for a bitmap falls back to a sorted vector.
+//
+// Consecutive insertions into the same subrun, the order in which
+// events are read from a FileIndex, take constant time.
+// ======================================================================
+
+#include "canvas/Persistency/Provenance/EventID.h"
+#include "canvas/Persistency/Provenance/SubRunID.h"
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace art {
+  class FileIndex;
+}
+
+namespace art::detail {
+
+  class EventIDSet {
+  public:
+    // Prepare for the insertion of the events listed in the index.
+    // This only sizes the set; no event is inserted.
+    void reserve(FileIndex const& fileIndex);
+
+    // Returns false if the event was already in the set.
+    bool insert(EventID const& id);
+
+    void clear();
+
+  private:
+    class SubRunEvents {
+    public:
+      void reserve(EventNumber_t first,
+                   EventNumber_t last,
+                   std::size_t nEvents);
+      bool insert(EventNumber_t event);
+
+    private:
+      void makeSparse();
+
+      std::size_t nEvents_{};
+      EventNumber_t first_{};
+      std::vector<bool> dense_{};
+      bool isSparse_{false};
+      std::vector<EventNumber_t> sparse_{};
+    };
+
+    SubRunEvents& subRunEvents(SubRunID const& id);
+
+    std::map<SubRunID, SubRunEvents> subRuns_{};
+    SubRunID lastSubRun_{};
+    SubRunEvents* lastEvents_{nullptr};
+  };
+
+} // namespace art::detail
+
+#endif /* art_root_io_detail_EventIDSet_h */
+
+// Local variables:
+// mode: c++
+// End:
@@ -0,0 +1,207 @@
+#include "art_root_io/detail/EventIndexDB.h"
+// vim: set sw=2 expandtab :
+
+#include "canvas/Persistency/Provenance/FileIndex.h"
+#include "canvas/Utilities/Exception.h"
+#include "cetlib/sqlite/Transaction.h"
+
+#include "sqlite3.h"
+
+namespace {
+
+  sqlite3*
+  open(std::string const& fileName, int const flags)
+  {
+    sqlite3* db{nullptr};
+    if (sqlite3_open_v2(fileName.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+      std::string const msg{db != nullptr ? sqlite3_errmsg(db) :
+                                            "out of memory"};
+      sqlite3_close(db);
+      throw art::Exception{art::errors::FileOpenError}
+        << "Unable to open event index " << fileName << ".\n"
+        << "SQLite error: " << msg << '\n';
+    }
+    return db;
+  }
+
+  void
+  exec(sqlite3* db, std::string const& ddl)
+  {
+    char* errmsg{nullptr};
+    if (sqlite3_exec(db, ddl.c_str(), nullptr, nullptr, &errmsg) !=
+        SQLITE_OK) {
+      std::string const msg{errmsg != nullptr ? errmsg : ""};
+      sqlite3_free(errmsg);
+      throw art::Exception{art::errors::SQLExecutionError}
+        << "Error executing statement on the event index.\n"
+        << "Statement: " << ddl << '\n'
+        << "SQLite error: " << msg << '\n';
+    }
+  }
+
+  sqlite3_stmt*
+  prepare(sqlite3* db, std::string const& ddl)
+  {
+    sqlite3_stmt* stmt{nullptr};
+    if (sqlite3_prepare_v2(db, ddl.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+      throw art::Exception{art::errors::SQLExecutionError}
+        << "Error in preparing statement for the event index.\n"
+        << "Preparation statement: " << ddl << '\n'
+        << "SQLite error: " << sqlite3_errmsg(db) << '\n';
+    }
+    return stmt;
+  }
+
+  void
+  step_done(sqlite3* db, sqlite3_stmt* stmt)
+  {
+    auto const rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE) {
+      throw art::Exception{art::errors::SQLExecutionError}
+        << "Unexpected status from event-index statement (" << rc
+        << "): " << sqlite3_errmsg(db) << '\n'
+        << "Statement: " << sqlite3_sql(stmt) << '\n';
+    }
+  }
+
+} // namespace
+
+namespace art::detail {
+
+  void
+  event_index::CloseDB::operator()(sqlite3* const db) const noexcept
+  {
+    sqlite3_close(db);
+  }
+
+  void
+  event_index::FinalizeStatement::operator()(
+    sqlite3_stmt* const stmt) const noexcept
+  {
+    sqlite3_finalize(stmt);
+  }
+
+  EventIndexWriter::EventIndexWriter(std::string const& indexFileName)
+    : db_{open(indexFileName, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)}
+  {
+    exec(db_.get(),
+         "CREATE TABLE IF NOT EXISTS Files(FileID INTEGER PRIMARY KEY, "
+         "Name TEXT UNIQUE);"
+         "CREATE TABLE IF NOT EXISTS EventRanges(Run INTEGER, "
+         "SubRun INTEGER, BeginEvent INTEGER, EndEvent INTEGER, "
+         "FileID INTEGER);"
+         "CREATE INDEX IF NOT EXISTS EventRangesByEvent ON "
+         "EventRanges(Run, SubRun, BeginEvent);"
+         "CREATE INDEX IF NOT EXISTS EventRangesByFile ON "
+         "EventRanges(FileID);");
+    insertFile_.reset(
+      prepare(db_.get(), "INSERT OR IGNORE INTO Files(Name) VALUES(?);"));
+    selectFileID_.reset(
+      prepare(db_.get(), "SELECT FileID FROM Files WHERE Name = ?;"));
+    deleteRanges_.reset(
+      prepare(db_.get(), "DELETE FROM EventRanges WHERE FileID = ?;"));
+    insertRange_.reset(prepare(db_.get(),
+                               "INSERT INTO EventRanges(Run, SubRun, "
+                               "BeginEvent, EndEvent, FileID) "
+                               "VALUES(?,?,?,?,?);"));
+  }
+
+  void
+  EventIndexWriter::addFile(std::string const& fileName, FileIndex fileIndex)
+  {
+    cet::sqlite::Transaction txn{db_.get()};
+    sqlite3_bind_text(insertFile_.get(),
+                      1,
+                      fileName.c_str(),
+                      fileName.size(),
+                      SQLITE_TRANSIENT);
+    step_done(db_.get(), insertFile_.get());
+
+    sqlite3_bind_text(selectFileID_.get(),
+                      1,
+                      fileName.c_str(),
+                      fileName.size(),
+                      SQLITE_TRANSIENT);
+    if (sqlite3_step(selectFileID_.get()) != SQLITE_ROW) {
+      sqlite3_reset(selectFileID_.get());
+      throw Exception{errors::SQLExecutionError}
+        << "Could not retrieve the ID of file " << fileName
+        << " from the event index.\n";
+    }
+    auto const fileID = sqlite3_column_int64(selectFileID_.get(), 0);
+    sqlite3_reset(selectFileID_.get());
+
+    sqlite3_bind_int64(deleteRanges_.get(), 1, fileID);
+    step_done(db_.get(), deleteRanges_.get());
+
+    auto insert = [this, fileID](EventID const& begin,
+                                 EventNumber_t const end) {
+      sqlite3_bind_int64(insertRange_.get(), 1, begin.run());
+      sqlite3_bind_int64(insertRange_.get(), 2, begin.subRun());
+      sqlite3_bind_int64(insertRange_.get(), 3, begin.event());
+      sqlite3_bind_int64(insertRange_.get(), 4, end);
+      sqlite3_bind_int64(insertRange_.get(), 5, fileID);
+      step_done(db_.get(), insertRange_.get());
+    };
+
+    // Consecutive event numbers of a subrun are recorded as one range.
+    fileIndex.sortBy_Run_SubRun_Event();
+    std::optional<EventID> begin;
+    EventNumber_t end{};
+    for (auto const& element : fileIndex) {
+      if (element.getEntryType() != FileIndex::kEvent) {
+        continue;
+      }
+      auto const& id = element.eventID;
+      if (begin && id.subRunID() == begin->subRunID() &&
+          (id.event() == end || id.event() == end + 1)) {
+        end = id.event();
+        continue;
+      }
+      if (begin) {
+        insert(*begin, end);
+      }
+      begin = id;
+      end = id.event();
+    }
+    if (begin) {
+      insert(*begin, end);
+    }
+    txn.commit();
+  }
+
+  EventIndexReader::EventIndexReader(std::string const& indexFileName)
+    : db_{open(indexFileName, SQLITE_OPEN_READONLY)}
+    , selectFile_{prepare(db_.get(),
+                          "SELECT Name FROM EventRanges JOIN Files "
+                          "USING(FileID) WHERE Run = ?1 AND SubRun = ?2 AND "
+                          "BeginEvent <= ?3 AND EndEvent >= ?3 "
+                          "ORDER BY BeginEvent DESC LIMIT 1;")}
+  {}
+
+  std::optional<std::string>
+  EventIndexReader::fileContaining(EventID const& id) const
+  {
+    if (!id.isValid() || id.isFlush()) {
+      return std::nullopt;
+    }
+    sqlite3_bind_int64(selectFile_.get(), 1, id.run());
+    sqlite3_bind_int64(selectFile_.get(), 2, id.subRun());
+    sqlite3_bind_int64(selectFile_.get(), 3, id.event());
+    std::optional<std::string> result;
+    auto const rc = sqlite3_step(selectFile_.get());
+    if (rc == SQLITE_ROW) {
+      result.emplace(reinterpret_cast<char const*>(
+        sqlite3_column_text(selectFile_.get(), 0)));
+    }
+    sqlite3_reset(selectFile_.get());
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+      throw Exception{errors::SQLExecutionError}
+        << "Unexpected status from event-index query (" << rc
+        << "): " << sqlite3_errmsg(db_.get()) << '\n';
+    }
+    return result;
+  }
+
+} // namespace art::detail
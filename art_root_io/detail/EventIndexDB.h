@@ -0,0 +1,86 @@
+#ifndef art_root_io_detail_EventIndexDB_h
+#define art_root_io_detail_EventIndexDB_h
+
+// ======================================================================
+// EventIndexDB
+//
+// A catalog-wide event index: an SQLite database, kept next to a set
+// of art/ROOT files, that records which file holds each event.  For
+// every file, the events of its FileIndex are stored as ranges of
+// consecutive event numbers within a subrun:
+//
+//   Files(FileID, Name)
+//   EventRanges(Run, SubRun, BeginEvent, EndEvent, FileID)
+//
+// with both ends of a range inclusive.  The file names are recorded as
+// they were given to the writer; a reader matches them against the
+// names of the input file catalog.
+//
+// EventIndexWriter adds (or replaces) the entries of one file at a
+// time; it is used by the event_index_builder executable.
+// EventIndexReader answers "which file contains this event?" with a
+// single indexed query.
+// ======================================================================
+
+#include "canvas/Persistency/Provenance/EventID.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace art {
+  class FileIndex;
+}
+
+namespace art::detail {
+
+  namespace event_index {
+    struct CloseDB {
+      void operator()(sqlite3* db) const noexcept;
+    };
+    struct FinalizeStatement {
+      void operator()(sqlite3_stmt* stmt) const noexcept;
+    };
+    using DB = std::unique_ptr<sqlite3, CloseDB>;
+    using Statement = std::unique_ptr<sqlite3_stmt, FinalizeStatement>;
+  }
+
+  class EventIndexWriter {
+  public:
+    // The database is created if it does not exist.
+    explicit EventIndexWriter(std::string const& indexFileName);
+
+    // Replaces any entries previously recorded for fileName.
+    void addFile(std::string const& fileName, FileIndex fileIndex);
+
+  private:
+    // Declared first, so that it is closed after its statements are
+    // finalized.
+    event_index::DB db_;
+    event_index::Statement insertFile_{};
+    event_index::Statement selectFileID_{};
+    event_index::Statement deleteRanges_{};
+    event_index::Statement insertRange_{};
+  };
+
+  class EventIndexReader {
+  public:
+    explicit EventIndexReader(std::string const& indexFileName);
+
+    std::optional<std::string> fileContaining(EventID const& id) const;
+
+  private:
+    event_index::DB db_;
+    event_index::Statement selectFile_;
+  };
+
+} // namespace art::detail
+
+#endif /* art_root_io_detail_EventIndexDB_h */
+
+// Local variables:
+// mode: c++
+// End:
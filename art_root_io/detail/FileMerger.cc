@@ -0,0 +1,564 @@
+#include "art_root_io/detail/FileMerger.h"
+// vim: set sw=2 expandtab :
+
+#include "art_root_io/GetFileFormatEra.h"
+#include "art_root_io/GetFileFormatVersion.h"
+#include "art_root_io/Inputfwd.h"
+#include "art_root_io/RootDB/have_table.h"
+#include "art_root_io/RootOutputTree.h"
+#include "art_root_io/detail/RangeSetResolver.h"
+#include "art_root_io/detail/RangeSetWriter.h"
+#include "art_root_io/detail/getObjectRequireDict.h"
+#include "art_root_io/detail/readFileIndex.h"
+#include "art_root_io/detail/readMetadata.h"
+#include "art_root_io/rootErrMsgs.h"
+#include "canvas/Persistency/Common/EDProduct.h"
+#include "canvas/Persistency/Provenance/FileFormatVersion.h"
+#include "canvas/Persistency/Provenance/ProductProvenance.h"
+#include "canvas/Persistency/Provenance/ResultsAuxiliary.h"
+#include "canvas/Persistency/Provenance/RunAuxiliary.h"
+#include "canvas/Persistency/Provenance/SubRunAuxiliary.h"
+#include "canvas/Persistency/Provenance/rootNames.h"
+#include "canvas/Utilities/Exception.h"
+#include "cetlib/canonical_string.h"
+#include "cetlib/sqlite/Ntuple.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+
+#include "TBranch.h"
+#include "TClass.h"
+#include "TFile.h"
+#include "TROOT.h"
+#include "TTree.h"
+#include "TTreeCloner.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <utility>
+
+using art::BranchType;
+using art::rootNames::metaBranchRootName;
+
+namespace {
+
+  // The basket size used by RootOutput by default.
+  constexpr int basketSize{16384};
+
+  // Old RangeSet ID -> new RangeSet ID, for the RangeSets of one input
+  // file that could not be recorded under their own IDs.
+  using RangeSetIDs = std::map<unsigned, unsigned>;
+
+  unsigned
+  newID(RangeSetIDs const& ids, unsigned const id)
+  {
+    auto const it = ids.find(id);
+    return it != ids.cend() ? it->second : id;
+  }
+
+  TTree*
+  getTree(TFile& file, std::string const& name, std::string const& fileName)
+  {
+    auto tree = file.Get<TTree>(name.c_str());
+    if (tree == nullptr) {
+      throw art::Exception{art::errors::FileReadError}
+        << couldNotFindTree(name) << "File: " << fileName << '\n';
+    }
+    return tree;
+  }
+
+  // The top-level branches of the input tree must be those of the
+  // output tree, with the same types.
+  void
+  checkBranches(TTree* in, TTree* out, std::string const& fileName)
+  {
+    auto describe = [](TTree* tree) {
+      std::map<std::string, std::string> result;
+      for (auto* obj : *tree->GetListOfBranches()) {
+        auto* branch = static_cast<TBranch*>(obj);
+        result.emplace(branch->GetName(), branch->GetClassName());
+      }
+      return result;
+    };
+    if (describe(in) != describe(out)) {
+      throw art::Exception{art::errors::MismatchedInputFiles}
+        << "The branches of tree " << in->GetName() << " in file "
+        << fileName << "\ndiffer from those of the files merged before it.\n"
+        << "Files with different data products must be merged with an art "
+           "job\n(RootInput and RootOutput).\n";
+    }
+  }
+
+  // Copies the entries of 'in' to 'out' one at a time, through objects
+  // of the branches' types, giving the RangeSets referred to by run and
+  // subrun auxiliaries and products their new IDs.
+  class EntryCopier {
+  public:
+    EntryCopier(TTree* in, TTree* out, BranchType const bt)
+      : in_{in}, out_{out}, bt_{bt}
+    {
+      auto* const edProduct = TClass::GetClass("art::EDProduct");
+      auto const& auxName = BranchTypeToAuxiliaryBranchName(bt);
+      auto* branches = in->GetListOfBranches();
+      buffers_.reserve(branches->GetEntriesFast());
+      for (auto* obj : *branches) {
+        auto* input = static_cast<TBranch*>(obj);
+        auto* cl = TClass::GetClass(input->GetClassName());
+        if (cl == nullptr || !cl->HasDictionary()) {
+          throw art::Exception{art::errors::DictionaryNotFound}
+            << "No dictionary found for class " << input->GetClassName()
+            << " of branch " << input->GetName() << ".\n";
+        }
+        auto& b = buffers_.emplace_back();
+        b.input = input;
+        b.output = out->GetBranch(input->GetName());
+        b.cl = cl;
+        b.object = cl->New();
+        b.isAuxiliary = auxName == input->GetName();
+        if (edProduct != nullptr) {
+          b.productOffset = cl->GetBaseClassOffset(edProduct);
+        }
+        b.input->SetAddress(&b.object);
+        b.output->SetAddress(&b.object);
+      }
+    }
+
+    ~EntryCopier()
+    {
+      in_->ResetBranchAddresses();
+      out_->ResetBranchAddresses();
+      for (auto& b : buffers_) {
+        b.cl->Destructor(b.object);
+      }
+    }
+
+    EntryCopier(EntryCopier const&) = delete;
+    EntryCopier& operator=(EntryCopier const&) = delete;
+
+    void
+    copy(RangeSetIDs const& ids)
+    {
+      for (Long64_t i = 0, n = in_->GetEntries(); i != n; ++i) {
+        for (auto& b : buffers_) {
+          art::input::getEntry(b.input, i);
+          if (!ids.empty()) {
+            updateRangeSetID(b, ids);
+          }
+        }
+        out_->Fill();
+      }
+    }
+
+  private:
+    struct Buffer {
+      TBranch* input{nullptr};
+      TBranch* output{nullptr};
+      TClass* cl{nullptr};
+      void* object{nullptr};
+      bool isAuxiliary{false};
+      // Negative if the type does not derive from art::EDProduct.
+      Int_t productOffset{-1};
+    };
+
+    void
+    updateRangeSetID(Buffer const& b, RangeSetIDs const& ids) const
+    {
+      if (b.isAuxiliary) {
+        if (bt_ == art::InSubRun) {
+          auto& aux = *static_cast<art::SubRunAuxiliary*>(b.object);
+          aux.setRangeSetID(newID(ids, aux.rangeSetID()));
+        } else if (bt_ == art::InRun) {
+          auto& aux = *static_cast<art::RunAuxiliary*>(b.object);
+          aux.setRangeSetID(newID(ids, aux.rangeSetID()));
+        }
+        return;
+      }
+      if (b.productOffset < 0) {
+        return;
+      }
+      auto* product = reinterpret_cast<art::EDProduct*>(
+        static_cast<char*>(b.object) + b.productOffset);
+      product->setRangeSetID(newID(ids, product->getRangeSetID()));
+    }
+
+    TTree* in_;
+    TTree* out_;
+    BranchType const bt_;
+    std::vector<Buffer> buffers_{};
+  };
+
+  // Returns true if the baskets of 'in' were copied as they are.  The
+  // entries are copied one at a time otherwise, and whenever 'ids' is
+  // given.
+  bool
+  copyTree(TTree* in,
+           TTree* out,
+           BranchType const bt,
+           RangeSetIDs const* ids = nullptr)
+  {
+    if (in->GetEntries() == 0) {
+      return true;
+    }
+    if (ids == nullptr) {
+      TTreeCloner cloner{
+        in, out, "", TTreeCloner::kNoWarnings | TTreeCloner::kNoFileCache};
+      if (cloner.IsValid()) {
+        out->SetEntries(out->GetEntries() + in->GetEntries());
+        cloner.Exec();
+        return true;
+      }
+    }
+    EntryCopier copier{in, out, bt};
+    copier.copy(ids != nullptr ? *ids : RangeSetIDs{});
+    return false;
+  }
+
+  // The first input tree of each kind gives the structure of the output
+  // tree.
+  TTree*
+  makeOutputTree(TTree* in, TFile& file)
+  {
+    TDirectory::TContext const context{&file};
+    auto tree = in->CloneTree(0);
+    if (tree == nullptr) {
+      throw art::Exception{art::errors::FatalRootError}
+        << "Failed to create the output tree " << in->GetName() << ".\n";
+    }
+    tree->ResetBranchAddresses();
+    in->ResetBranchAddresses();
+    tree->SetDirectory(&file);
+    // As for the trees of RootOutput, avoid leaving deleted tree keys
+    // in the output file.
+    tree->SetAutoSave(std::numeric_limits<Long64_t>::max());
+    return tree;
+  }
+
+  template <typename T>
+  void
+  writeObject(TTree* tree, T const& object)
+  {
+    auto const* p = &object;
+    TBranch* b = tree->Branch(metaBranchRootName<T>(), &p, basketSize, 0);
+    if (b == nullptr) {
+      throw art::Exception{art::errors::FatalRootError}
+        << "Failed to create a branch for " << metaBranchRootName<T>()
+        << " in the output file.\n";
+    }
+    b->Fill();
+  }
+
+} // unnamed namespace
+
+namespace art::detail {
+
+  FileMerger::FileMerger(std::string const& outputFileName,
+                         int const compressionLevel,
+                         unsigned const lookAhead)
+    : file_{TFile::Open(outputFileName.c_str(),
+                        "recreate",
+                        "",
+                        compressionLevel)}
+    , pipeline_{std::max(lookAhead, 1u)}
+  {
+    if (!file_ || file_->IsZombie()) {
+      throw Exception{errors::FileOpenError}
+        << "Unable to open output file " << outputFileName << ".\n";
+    }
+    // The input files are opened on background threads.
+    ROOT::EnableThreadSafety();
+    db_.reset(
+      file_.get(), "RootFileDB", SQLITE_OPEN_CREATE | SQLITE_OPEN_READWRITE);
+    RangeSetWriter::createTables(db_);
+    rangeSetWriter_ = std::make_unique<RangeSetWriter>(db_);
+  }
+
+  FileMerger::~FileMerger() = default;
+
+  void
+  FileMerger::merge(std::vector<std::string> const& fileNames,
+                    std::ostream& log)
+  {
+    for (auto it = fileNames.cbegin(), e = fileNames.cend(); it != e; ++it) {
+      pipeline_.schedule(it, e);
+      auto file = pipeline_.take(*it);
+      if (!file || !*file) {
+        throw Exception{errors::FileOpenError}
+          << "Unable to open file " << *it << " for reading.\n";
+      }
+      mergeFile(*it, **file, log);
+    }
+  }
+
+  void
+  FileMerger::mergeFile(std::string const& fileName,
+                        TFile& file,
+                        std::ostream& log)
+  {
+    auto md = getTree(file, rootNames::metaDataTreeName(), fileName);
+    auto const version = detail::readMetadata<FileFormatVersion>(md);
+    if (version.era_ != getFileFormatEra() ||
+        version.value_ != getFileFormatVersion()) {
+      throw Exception{errors::FileReadError}
+        << "File " << fileName << " has format version " << version
+        << ".\nOnly files of the current format version ("
+        << getFileFormatVersion() << ") can be merged without an art job.\n";
+    }
+
+    // Products and their dependencies.  The Results products are not
+    // copied.
+    auto const productList =
+      detail::readMetadata<ProductRegistry>(md, false).productList_;
+    auto const children = detail::readMetadata<BranchChildren>(md);
+    for (auto const& [key, pd] : productList) {
+      if (pd.branchType() == InResults) {
+        continue;
+      }
+      productList_.emplace(key, pd);
+      auto const pid = pd.productID();
+      std::set<ProductID> descendants;
+      children.appendToDescendants(pid, descendants);
+      branchChildren_.insertEmpty(pid);
+      for (auto const descendant : descendants) {
+        if (!(descendant == pid)) {
+          branchChildren_.insertChild(pid, descendant);
+        }
+      }
+    }
+
+    auto const histories = detail::readMetadata<ProcessHistoryMap>(md);
+    processHistories_.insert(histories.cbegin(), histories.cend());
+
+    FileIndex fileIndex;
+    auto fileIndexPtr = &fileIndex;
+    detail::readFileIndex(&file, md, fileIndexPtr);
+
+    readParentage(file);
+
+    // ParameterSets and RangeSets.  Each RangeSet ID of the file is
+    // kept if the output file does not yet use it for another RangeSet.
+    std::array<std::optional<RangeSetIDs>, NumBranchTypes> rangeSetIDs{};
+    {
+      SQLite3Wrapper db{&file, "RootFileDB", SQLITE_OPEN_READONLY};
+      if (have_table(db, "ParameterSets", fileName)) {
+        fhicl::ParameterSetRegistry::importFrom(db);
+      }
+      RangeSetResolver resolver{db, fileName, false};
+      for (auto const bt : {InSubRun, InRun}) {
+        auto const rangeSets = resolver.rangeSets(bt);
+        if (rangeSetWriter_->import(bt, rangeSets)) {
+          continue;
+        }
+        auto& ids = rangeSetIDs[bt].emplace();
+        for (auto const& [id, rs] : rangeSets) {
+          ids.emplace(id, rangeSetWriter_->rangeSetID(bt, rs));
+        }
+      }
+      rangeSetWriter_->flush();
+    }
+
+    // Data and provenance trees.
+    std::array<Long64_t, NumBranchTypes> firstEntries{};
+    std::vector<std::string> rewritten;
+    for (auto const bt : {InEvent, InSubRun, InRun}) {
+      auto data = getTree(file, BranchTypeToProductTreeName(bt), fileName);
+      auto meta = getTree(file, BranchTypeToMetaDataTreeName(bt), fileName);
+      auto& out = trees_[bt];
+      if (out.data == nullptr) {
+        out.data = makeOutputTree(data, *file_);
+        out.meta = makeOutputTree(meta, *file_);
+      } else {
+        checkBranches(data, out.data, fileName);
+        checkBranches(meta, out.meta, fileName);
+      }
+      firstEntries[bt] = out.data->GetEntries();
+      auto const* ids = rangeSetIDs[bt] ? &*rangeSetIDs[bt] : nullptr;
+      bool const metaCloned{copyTree(meta, out.meta, bt)};
+      bool const dataCloned{copyTree(data, out.data, bt, ids)};
+      if (!metaCloned || !dataCloned) {
+        rewritten.push_back(data->GetName());
+      }
+    }
+
+    unsigned long long events{};
+    for (auto const& element : fileIndex) {
+      auto const type = element.getEntryType();
+      auto const bt = type == FileIndex::kEvent  ? InEvent :
+                      type == FileIndex::kSubRun ? InSubRun :
+                                                   InRun;
+      if (bt == InEvent) {
+        ++events;
+      }
+      fileIndex_.addEntry(element.eventID, element.entry + firstEntries[bt]);
+    }
+    events_ += events;
+    parents_.push_back(fileName);
+
+    log << fileName << '\t' << events << " events";
+    if (!rewritten.empty()) {
+      log << "; entries copied one at a time for:";
+      for (auto const& name : rewritten) {
+        log << ' ' << name;
+      }
+    }
+    log << '\n';
+  }
+
+  void
+  FileMerger::readParentage(TFile& file)
+  {
+    auto tree = getTree(file, rootNames::parentageTreeName(), file.GetName());
+    auto idBuffer = root::getObjectRequireDict<ParentageID>();
+    auto pidBuffer = &idBuffer;
+    tree->SetBranchAddress(rootNames::parentageIDBranchName().c_str(),
+                           &pidBuffer);
+    auto parentageBuffer = root::getObjectRequireDict<Parentage>();
+    auto pParentageBuffer = &parentageBuffer;
+    tree->SetBranchAddress(rootNames::parentageBranchName().c_str(),
+                           &pParentageBuffer);
+    for (Long64_t i = 0, n = tree->GetEntries(); i != n; ++i) {
+      input::getEntry(tree, i);
+      if (idBuffer != parentageBuffer.id()) {
+        throw Exception{errors::DataCorruption}
+          << "Corruption of Parentage tree detected in file "
+          << file.GetName() << ".\n";
+      }
+      parentages_.emplace(idBuffer, parentageBuffer);
+    }
+    tree->SetBranchAddress(rootNames::parentageIDBranchName().c_str(),
+                           nullptr);
+    tree->SetBranchAddress(rootNames::parentageBranchName().c_str(), nullptr);
+  }
+
+  void
+  FileMerger::close()
+  {
+    if (trees_[InEvent].data == nullptr) {
+      throw Exception{errors::LogicError}
+        << "No input file has been merged into " << file_->GetName()
+        << ".\n";
+    }
+    writeResults();
+    writeMetadata();
+    fhicl::ParameterSetRegistry::exportTo(db_);
+    writeFileCatalogMetadata();
+    rangeSetWriter_->flush();
+    rangeSetWriter_.reset();
+    // The database is written to the file when it is closed.
+    db_.reset();
+    for (auto const& trees : trees_) {
+      for (auto* tree : {trees.data, trees.meta}) {
+        if (tree != nullptr) {
+          RootOutputTree::writeTTree(tree);
+        }
+      }
+    }
+    file_->Close();
+  }
+
+  void
+  FileMerger::writeResults()
+  {
+    // An entry without products, as written by RootOutput when there
+    // are no ResultsProducers.
+    auto& out = trees_[InResults];
+    out.data = RootOutputTree::makeTTree(
+      file_.get(), BranchTypeToProductTreeName(InResults), 0);
+    out.meta = RootOutputTree::makeTTree(
+      file_.get(), BranchTypeToMetaDataTreeName(InResults), 0);
+    auto aux = root::getObjectRequireDict<ResultsAuxiliary>();
+    auto const* pAux = &aux;
+    out.data->Branch(BranchTypeToAuxiliaryBranchName(InResults).c_str(),
+                     &pAux,
+                     basketSize,
+                     0);
+    ProductProvenances provenances;
+    auto const* pProvenances = &provenances;
+    out.meta->Branch(productProvenanceBranchName(InResults).c_str(),
+                     &pProvenances,
+                     basketSize,
+                     0);
+    out.data->Fill();
+    out.meta->Fill();
+    out.data->ResetBranchAddresses();
+    out.meta->ResetBranchAddresses();
+  }
+
+  void
+  FileMerger::writeMetadata()
+  {
+    auto metaDataTree = RootOutputTree::makeTTree(
+      file_.get(), rootNames::metaDataTreeName(), 0);
+    writeObject(metaDataTree,
+                FileFormatVersion{getFileFormatVersion(), getFileFormatEra()});
+    writeObject(metaDataTree, processHistories_);
+    ProductRegistry reg;
+    reg.productList_ = productList_;
+    writeObject(metaDataTree, reg);
+    writeObject(metaDataTree, branchChildren_);
+    RootOutputTree::writeTTree(metaDataTree);
+
+    auto fileIndexTree = RootOutputTree::makeTTree(
+      file_.get(), rootNames::fileIndexTreeName(), 0);
+    fileIndex_.sortBy_Run_SubRun_Event();
+    FileIndex::Element elem{};
+    auto const* findexElemPtr = &elem;
+    TBranch* b = fileIndexTree->Branch(
+      metaBranchRootName<FileIndex::Element>(), &findexElemPtr, basketSize, 0);
+    if (b == nullptr) {
+      throw Exception{errors::FatalRootError}
+        << "Failed to create a branch for the FileIndex in the output file.\n";
+    }
+    for (auto const& entry : fileIndex_) {
+      findexElemPtr = &entry;
+      b->Fill();
+    }
+    b->SetAddress(nullptr);
+    RootOutputTree::writeTTree(fileIndexTree);
+
+    auto parentageTree = RootOutputTree::makeTTree(
+      file_.get(), rootNames::parentageTreeName(), 0);
+    auto pid = root::getObjectRequireDict<ParentageID>();
+    ParentageID const* hash = &pid;
+    auto par = root::getObjectRequireDict<Parentage>();
+    Parentage const* desc = &par;
+    if (!parentageTree->Branch(
+          rootNames::parentageIDBranchName().c_str(), &hash, basketSize, 0) ||
+        !parentageTree->Branch(
+          rootNames::parentageBranchName().c_str(), &desc, basketSize, 0)) {
+      throw Exception{errors::FatalRootError}
+        << "Failed to create the Parentage branches in the output file.\n";
+    }
+    for (auto const& [id, parentage] : parentages_) {
+      hash = &id;
+      desc = &parentage;
+      parentageTree->Fill();
+    }
+    parentageTree->ResetBranchAddresses();
+    RootOutputTree::writeTTree(parentageTree);
+  }
+
+  void
+  FileMerger::writeFileCatalogMetadata()
+  {
+    using namespace cet::sqlite;
+    Ntuple<std::string, std::string> fileCatalogMetadata{
+      db_, "FileCatalog_metadata", {{"Name", "Value"}}, true};
+    fileCatalogMetadata.insert("file_format", "\"artroot\"");
+    fileCatalogMetadata.insert("event_count", std::to_string(events_));
+    std::ostringstream parents;
+    parents << "[ ";
+    for (auto const& parent : parents_) {
+      parents << cet::canonical_string(parent) << ", ";
+    }
+    // Rewind over last delimiter.
+    parents.seekp(-2, std::ios_base::cur);
+    parents << " ]";
+    fileCatalogMetadata.insert("parents", parents.str());
+    fileCatalogMetadata.insert("art.file_format_era",
+                               cet::canonical_string(getFileFormatEra()));
+    fileCatalogMetadata.insert("art.file_format_version",
+                               std::to_string(getFileFormatVersion()));
+  }
+
+} // namespace art::detail
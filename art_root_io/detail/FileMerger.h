@@ -0,0 +1,103 @@
+#ifndef art_root_io_detail_FileMerger_h
+#define art_root_io_detail_FileMerger_h
+
+// ======================================================================
+// FileMerger
+//
+// Concatenates art/ROOT files without running an art job; it is used
+// by the file_merger executable.  The baskets of the data and
+// provenance trees are copied as they are, with TTreeCloner.  The run
+// and subrun products refer to the RangeSets of their file's
+// RootFileDB by ID.  The RangeSets of each input file are therefore
+// recorded in the output RootFileDB under the same IDs when possible.
+// Otherwise, they are given new IDs, and the entries of the run and
+// subrun trees of that file are read, updated and written again.
+//
+// The FileIndex, product list, product dependencies, process
+// histories, parentage and ParameterSets of the input files are
+// merged.  A run or subrun that spans several input files is written
+// as one entry per file, to be combined when the output file is read.
+//
+// The input files must have the current file format, and the same
+// data branches.  Results products are not copied: they describe the
+// file that holds them.
+//
+// While a file is being copied, the files that follow it are opened,
+// and their metadata and tree headers read, on background threads.
+// ======================================================================
+
+#include "art_root_io/RootDB/SQLite3Wrapper.h"
+#include "art_root_io/detail/FileOpenPipeline.h"
+#include "canvas/Persistency/Provenance/BranchChildren.h"
+#include "canvas/Persistency/Provenance/BranchType.h"
+#include "canvas/Persistency/Provenance/FileIndex.h"
+#include "canvas/Persistency/Provenance/Parentage.h"
+#include "canvas/Persistency/Provenance/ParentageID.h"
+#include "canvas/Persistency/Provenance/ProcessHistory.h"
+#include "canvas/Persistency/Provenance/ProductList.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+namespace art::detail {
+
+  class RangeSetWriter;
+
+  class FileMerger {
+  public:
+    // The input files are opened up to 'lookAhead' at a time.
+    FileMerger(std::string const& outputFileName,
+               int compressionLevel,
+               unsigned lookAhead);
+    ~FileMerger();
+
+    FileMerger(FileMerger const&) = delete;
+    FileMerger& operator=(FileMerger const&) = delete;
+
+    // Appends the contents of the files, in order, to the output file.
+    // Throws if a file cannot be opened or merged.
+    void merge(std::vector<std::string> const& fileNames, std::ostream& log);
+
+    // Writes the merged metadata and closes the output file.
+    void close();
+
+  private:
+    struct Trees {
+      TTree* data{nullptr};
+      TTree* meta{nullptr};
+    };
+
+    void mergeFile(std::string const& fileName, TFile& file, std::ostream& log);
+    void readParentage(TFile& file);
+    void writeResults();
+    void writeMetadata();
+    void writeFileCatalogMetadata();
+
+    std::unique_ptr<TFile> file_;
+    SQLite3Wrapper db_;
+    std::unique_ptr<RangeSetWriter> rangeSetWriter_;
+    FileOpenPipeline pipeline_;
+    std::array<Trees, NumBranchTypes> trees_{};
+    FileIndex fileIndex_{};
+    ProductList productList_{};
+    BranchChildren branchChildren_{};
+    ProcessHistoryMap processHistories_{};
+    std::map<ParentageID, Parentage> parentages_{};
+    std::vector<std::string> parents_{};
+    unsigned long long events_{};
+  };
+
+} // namespace art::detail
+
+#endif /* art_root_io_detail_FileMerger_h */
+
+// Local variables:
+// mode: c++
+// End:
@@ -0,0 +1,141 @@
+#include "art_root_io/detail/FileOpenPipeline.h"
+// vim: set sw=2 expandtab :
+
+#include "canvas/Persistency/Provenance/BranchType.h"
+#include "canvas/Persistency/Provenance/rootNames.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+  using cancel_flag_t = std::shared_ptr<std::atomic<bool>>;
+
+  std::unique_ptr<TFile>
+  openAndPreload(std::string const& fileName, cancel_flag_t const cancelled)
+  {
+    if (*cancelled) {
+      return nullptr;
+    }
+    std::unique_ptr<TFile> file{TFile::Open(fileName.c_str())};
+    if (!file || file->IsZombie()) {
+      return nullptr;
+    }
+
+    // The metadata trees are small and read in full by RootInputFile.
+    using namespace art::rootNames;
+    for (auto const& treeName : {metaDataTreeName(),
+                                 fileIndexTreeName(),
+                                 parentageTreeName(),
+                                 eventHistoryTreeName()}) {
+      if (*cancelled) {
+        return nullptr;
+      }
+      if (auto tree = file->Get<TTree>(treeName.c_str())) {
+        tree->LoadBaskets();
+      }
+    }
+
+    // Only the headers of the data and provenance trees are read; for
+    // files with many branches they are the expensive part.
+    for (int bt = art::InEvent; bt != art::NumBranchTypes; ++bt) {
+      if (*cancelled) {
+        return nullptr;
+      }
+      auto const branchType = static_cast<art::BranchType>(bt);
+      file->Get<TTree>(art::BranchTypeToProductTreeName(branchType).c_str());
+      file->Get<TTree>(art::BranchTypeToMetaDataTreeName(branchType).c_str());
+    }
+    return file;
+  }
+
+} // unnamed namespace
+
+namespace art::detail {
+
+  FileOpenPipeline::FileOpenPipeline(unsigned const depth)
+    : depth_{depth}, cancelled_{std::make_shared<std::atomic<bool>>(false)}
+  {}
+
+  FileOpenPipeline::~FileOpenPipeline()
+  {
+    cancel();
+  }
+
+  void
+  FileOpenPipeline::schedule(const_iterator const begin,
+                             const_iterator const end)
+  {
+    // The files already pending come first, so no more than 'depth'
+    // names need to be examined.
+    auto const last = begin + std::min<std::ptrdiff_t>(end - begin, depth_);
+    for (auto it = begin; it != last; ++it) {
+      auto const& fileName = *it;
+      if (pending_.size() >= depth_) {
+        return;
+      }
+      auto const scheduled =
+        std::any_of(pending_.cbegin(), pending_.cend(), [&fileName](auto& p) {
+          return p.fileName == fileName;
+        });
+      if (scheduled) {
+        continue;
+      }
+      pending_.push_back(
+        {fileName,
+         std::async(std::launch::async, openAndPreload, fileName, cancelled_)});
+    }
+  }
+
+  std::optional<std::unique_ptr<TFile>>
+  FileOpenPipeline::take(std::string const& fileName)
+  {
+    auto it = std::find_if(pending_.begin(),
+                           pending_.end(),
+                           [&fileName](auto const& p) {
+                             return p.fileName == fileName;
+                           });
+    if (it == pending_.end()) {
+      cancel();
+      return std::nullopt;
+    }
+    for (auto skipped = pending_.begin(); skipped != it; ++skipped) {
+      discard(*skipped);
+    }
+    auto future = std::move(it->file);
+    pending_.erase(pending_.begin(), std::next(it));
+    return future.get();
+  }
+
+  void
+  FileOpenPipeline::cancel()
+  {
+    if (pending_.empty()) {
+      return;
+    }
+    *cancelled_ = true;
+    for (auto& p : pending_) {
+      discard(p);
+    }
+    pending_.clear();
+    // Files scheduled from now on belong to a new generation.
+    cancelled_ = std::make_shared<std::atomic<bool>>(false);
+  }
+
+  void
+  FileOpenPipeline::discard(Pending& pending)
+  {
+    // The task must be finished before its file can be closed; an
+    // error that occurred while opening a discarded file is of no
+    // interest.
+    try {
+      pending.file.get();
+    }
+    catch (...) {
+    }
+  }
+
+} // namespace art::detail
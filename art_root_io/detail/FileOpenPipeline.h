@@ -0,0 +1,86 @@
+#ifndef art_root_io_detail_FileOpenPipeline_h
+#define art_root_io_detail_FileOpenPipeline_h
+
+// ======================================================================
+// FileOpenPipeline
+//
+// Opens the input files that are expected to be read next on
+// background threads, at most 'depth' of them ahead of the file in
+// use.  Besides opening the file, each background task reads the
+// headers of the art trees and loads the baskets of the metadata
+// trees, so that a RootInputFile constructed from the file finds them
+// in memory.
+//
+// A file handed out by take() is used only by the calling thread from
+// then on.  The pipeline may be cancelled at any time; tasks that have
+// not yet finished close their files and return nothing.
+// ======================================================================
+
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class TFile;
+
+namespace art::detail {
+
+  class FileOpenPipeline {
+  public:
+    explicit FileOpenPipeline(unsigned depth);
+    ~FileOpenPipeline();
+
+    FileOpenPipeline(FileOpenPipeline const&) = delete;
+    FileOpenPipeline& operator=(FileOpenPipeline const&) = delete;
+
+    // Schedule the files of [begin, end), in the order in which they
+    // are expected to be taken, until 'depth' files are pending.  Files
+    // already pending are not scheduled again.  At most 'depth' names
+    // are examined.
+    using const_iterator = std::vector<std::string>::const_iterator;
+    void schedule(const_iterator begin, const_iterator end);
+    void
+    schedule(std::vector<std::string> const& fileNames)
+    {
+      schedule(fileNames.cbegin(), fileNames.cend());
+    }
+
+    // If fileName is pending, wait for it and return the file, or a
+    // null pointer if it could not be opened; an exception thrown while
+    // opening it is rethrown.  Files scheduled before it are discarded.
+    // If fileName is not pending, all pending files are discarded and
+    // std::nullopt is returned.
+    std::optional<std::unique_ptr<TFile>> take(std::string const& fileName);
+
+    // Discard all pending files.
+    void cancel();
+
+    std::size_t
+    pending() const
+    {
+      return pending_.size();
+    }
+
+  private:
+    struct Pending {
+      std::string fileName;
+      std::future<std::unique_ptr<TFile>> file;
+    };
+
+    void discard(Pending& pending);
+
+    unsigned const depth_;
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+    std::deque<Pending> pending_{};
+  };
+
+} // namespace art::detail
+
+#endif /* art_root_io_detail_FileOpenPipeline_h */
+
+// Local variables:
+// mode: c++
+// End:
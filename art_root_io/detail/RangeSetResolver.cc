@@ -0,0 +1,165 @@
+#include "art_root_io/detail/RangeSetResolver.h"
+// vim: set sw=2 expandtab :
+
+#include "canvas/Utilities/Exception.h"
+
+#include "sqlite3.h"
+
+#include <limits>
+#include <vector>
+
+namespace {
+
+  sqlite3_stmt*
+  prepare(sqlite3* db, std::string const& ddl, std::string const& filename)
+  {
+    sqlite3_stmt* stmt{nullptr};
+    if (sqlite3_prepare_v2(db, ddl.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+      throw art::Exception{art::errors::SQLExecutionError}
+        << "Error in preparing statement for getting contributors.\n"
+        << "File: " << filename << '\n'
+        << "Preparation statement: " << ddl << '\n'
+        << "SQLite error: " << sqlite3_errmsg(db) << '\n';
+    }
+    return stmt;
+  }
+
+  void
+  bind_id(sqlite3* db,
+          sqlite3_stmt* stmt,
+          unsigned const rangeSetID,
+          std::string const& filename)
+  {
+    sqlite3_reset(stmt);
+    if (sqlite3_bind_int64(stmt, 1, rangeSetID) != SQLITE_OK) {
+      throw art::Exception{art::errors::SQLExecutionError}
+        << "Unable to bind RangeSet ID " << rangeSetID << ": "
+        << sqlite3_errmsg(db) << '\n'
+        << "File: " << filename << '\n';
+    }
+  }
+
+} // namespace
+
+namespace art::detail {
+
+  RangeSetResolver::RangeSetResolver(sqlite3* db,
+                                     std::string filename,
+                                     bool const compact)
+    : db_{db}, filename_{std::move(filename)}, compact_{compact}
+  {}
+
+  RangeSetResolver::~RangeSetResolver()
+  {
+    for (auto const& stmts : statements_) {
+      sqlite3_finalize(stmts.run);
+      sqlite3_finalize(stmts.ranges);
+    }
+  }
+
+  RangeSetInfo const&
+  RangeSetResolver::info(BranchType const bt, unsigned const rangeSetID)
+  {
+    if (rangeSetID == std::numeric_limits<unsigned>::max()) {
+      return invalid_;
+    }
+    std::lock_guard sentry{mutex_};
+    auto const key = std::make_pair(bt, rangeSetID);
+    if (auto it = resolved_.find(key); it != resolved_.cend()) {
+      return it->second;
+    }
+    return resolved_.emplace(key, query(bt, rangeSetID)).first->second;
+  }
+
+  RangeSet
+  RangeSetResolver::rangeSet(BranchType const bt, unsigned const rangeSetID)
+  {
+    auto const& rsi = info(bt, rangeSetID);
+    if (rsi.is_invalid()) {
+      return RangeSet::invalid();
+    }
+    return RangeSet{rsi.run, rsi.ranges};
+  }
+
+  std::vector<std::pair<unsigned, RangeSet>>
+  RangeSetResolver::rangeSets(BranchType const bt)
+  {
+    std::vector<unsigned> ids;
+    {
+      std::lock_guard sentry{mutex_};
+      auto const ddl = "SELECT rowid FROM " + BranchTypeToString(bt) +
+                       "RangeSets ORDER BY rowid;";
+      auto* stmt = prepare(db_, ddl, filename_);
+      int rc{};
+      while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        ids.push_back(static_cast<unsigned>(sqlite3_column_int64(stmt, 0)));
+      }
+      sqlite3_finalize(stmt);
+      if (rc != SQLITE_DONE) {
+        throw Exception{errors::SQLExecutionError}
+          << "Unexpected status from table read: " << sqlite3_errmsg(db_)
+          << " (" << rc << ").\n"
+          << "File: " << filename_ << '\n';
+      }
+    }
+    std::vector<std::pair<unsigned, RangeSet>> result;
+    result.reserve(ids.size());
+    for (auto const id : ids) {
+      result.emplace_back(id, rangeSet(bt, id));
+    }
+    return result;
+  }
+
+  RangeSetResolver::Statements const&
+  RangeSetResolver::statements(BranchType const bt)
+  {
+    auto& stmts = statements_[bt];
+    if (stmts.run != nullptr) {
+      return stmts;
+    }
+    auto const table = BranchTypeToString(bt) + "RangeSets";
+    stmts.run =
+      prepare(db_, "SELECT Run FROM " + table + " WHERE rowid==?;", filename_);
+    std::string const result_columns{compact_ ? "min(begin),max(end)" :
+                                                "begin,end"};
+    std::string const maybe_suffix{compact_ ? " GROUP BY SubRun" : ""};
+    stmts.ranges =
+      prepare(db_,
+              "SELECT SubRun," + result_columns +
+                " FROM EventRanges WHERE rowid IN"
+                "(SELECT EventRangesID FROM " +
+                table + "_EventRanges WHERE RangeSetsID==?)" + maybe_suffix +
+                ';',
+              filename_);
+    return stmts;
+  }
+
+  RangeSetInfo
+  RangeSetResolver::query(BranchType const bt, unsigned const rangeSetID)
+  {
+    auto const& stmts = statements(bt);
+
+    bind_id(db_, stmts.run, rangeSetID, filename_);
+    sqlite3_step(stmts.run);
+    auto const r = static_cast<RunNumber_t>(sqlite3_column_int(stmts.run, 0));
+    sqlite3_reset(stmts.run);
+
+    bind_id(db_, stmts.ranges, rangeSetID, filename_);
+    std::vector<EventRange> ranges;
+    int rc{};
+    while ((rc = sqlite3_step(stmts.ranges)) == SQLITE_ROW) {
+      ranges.emplace_back(sqlite3_column_int(stmts.ranges, 0),
+                          sqlite3_column_int(stmts.ranges, 1),
+                          sqlite3_column_int(stmts.ranges, 2));
+    }
+    if (rc != SQLITE_DONE) {
+      throw Exception{errors::SQLExecutionError}
+        << "Unexpected status from table read: " << sqlite3_errmsg(db_)
+        << " (" << rc << ").\n"
+        << "File: " << filename_ << '\n';
+    }
+    sqlite3_reset(stmts.ranges);
+    return RangeSetInfo{r, std::move(ranges)};
+  }
+
+} // namespace art::detail
@@ -0,0 +1,67 @@
+#ifndef art_root_io_detail_RangeSetResolver_h
+#define art_root_io_detail_RangeSetResolver_h
+
+// ======================================================================
+// RangeSetResolver
+//
+// Resolves the RangeSets stored in the RootFileDB of one input file.
+// The SQL statements are prepared once per branch type and the
+// resolved (BranchType, rangeSetID) -> RangeSetInfo mappings are
+// memoized for the lifetime of the resolver, which must not outlive
+// the database connection.  All member functions are thread-safe.
+// ======================================================================
+
+#include "art_root_io/detail/RangeSetInfo.h"
+#include "canvas/Persistency/Provenance/BranchType.h"
+#include "canvas/Persistency/Provenance/RangeSet.h"
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace art::detail {
+
+  class RangeSetResolver {
+  public:
+    RangeSetResolver(sqlite3* db, std::string filename, bool compact);
+    ~RangeSetResolver();
+
+    RangeSetResolver(RangeSetResolver const&) = delete;
+    RangeSetResolver& operator=(RangeSetResolver const&) = delete;
+
+    RangeSetInfo const& info(BranchType, unsigned rangeSetID);
+    RangeSet rangeSet(BranchType, unsigned rangeSetID);
+    // All RangeSets stored for the branch type, with their IDs.
+    std::vector<std::pair<unsigned, RangeSet>> rangeSets(BranchType);
+
+  private:
+    struct Statements {
+      sqlite3_stmt* run{nullptr};
+      sqlite3_stmt* ranges{nullptr};
+    };
+
+    Statements const& statements(BranchType);
+    RangeSetInfo query(BranchType, unsigned rangeSetID);
+
+    sqlite3* db_;
+    std::string const filename_;
+    bool const compact_;
+    RangeSetInfo const invalid_{RangeSetInfo::invalid()};
+    std::mutex mutex_{};
+    std::array<Statements, NumBranchTypes> statements_{};
+    std::map<std::pair<BranchType, unsigned>, RangeSetInfo> resolved_{};
+  };
+
+} // namespace art::detail
+
+#endif /* art_root_io_detail_RangeSetResolver_h */
+
+// Local variables:
+// mode: c++
+// End:
@@ -0,0 +1,223 @@
+#include "art_root_io/detail/RangeSetWriter.h"
+// vim: set sw=2 expandtab :
+
+#include "art/Framework/Principal/RangeSetsSupported.h"
+#include "canvas/Utilities/Exception.h"
+#include "cetlib/sqlite/Transaction.h"
+#include "cetlib/sqlite/create_table.h"
+#include "cetlib/sqlite/exec.h"
+
+#include "sqlite3.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+  void
+  create_table(sqlite3* const db,
+               std::string const& name,
+               std::vector<std::string> const& columns,
+               std::string const& suffix = {})
+  {
+    if (columns.empty())
+      throw art::Exception(art::errors::LogicError)
+        << "Number of sqlite columns specified for table: " << name << '\n'
+        << "is zero.\n";
+    std::string ddl = "DROP TABLE IF EXISTS " + name +
+                      "; "
+                      "CREATE TABLE " +
+                      name + "(" + columns.front();
+    std::for_each(columns.begin() + 1,
+                  columns.end(),
+                  [&ddl](auto const& col) { ddl += "," + col; });
+    ddl += ") ";
+    ddl += suffix;
+    ddl += ";";
+    cet::sqlite::exec(db, ddl);
+  }
+
+  sqlite3_stmt*
+  prepare(sqlite3* db, std::string const& ddl)
+  {
+    sqlite3_stmt* stmt{nullptr};
+    if (sqlite3_prepare_v2(db, ddl.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+      throw art::Exception{art::errors::SQLExecutionError}
+        << "Error in preparing statement for writing RangeSets.\n"
+        << "Preparation statement: " << ddl << '\n'
+        << "SQLite error: " << sqlite3_errmsg(db) << '\n';
+    }
+    return stmt;
+  }
+
+  template <typename... Args>
+  void
+  insert_row(sqlite3* db, sqlite3_stmt* stmt, Args const... args)
+  {
+    int i{};
+    (sqlite3_bind_int64(stmt, ++i, args), ...);
+    auto const rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE) {
+      throw art::Exception{art::errors::SQLExecutionError}
+        << "Unexpected status from insertion (" << rc
+        << "): " << sqlite3_errmsg(db) << '\n'
+        << "Statement: " << sqlite3_sql(stmt) << '\n';
+    }
+  }
+
+} // namespace
+
+namespace art::detail {
+
+  void
+  RangeSetWriter::createTables(sqlite3* const db)
+  {
+    // Event ranges
+    create_table(db,
+                 "EventRanges",
+                 {"SubRun INTEGER",
+                  "begin INTEGER",
+                  "end INTEGER",
+                  "UNIQUE (SubRun,begin,end) ON CONFLICT IGNORE"});
+    // SubRun range sets
+    using namespace cet::sqlite;
+    create_table(db, "SubRunRangeSets", column<int>{"Run"});
+    create_table(db,
+                 "SubRunRangeSets_EventRanges",
+                 {"RangeSetsID INTEGER",
+                  "EventRangesID INTEGER",
+                  "PRIMARY KEY(RangeSetsID,EventRangesID)"},
+                 "WITHOUT ROWID");
+    // Run range sets
+    create_table(db, "RunRangeSets", column<int>{"Run"});
+    create_table(db,
+                 "RunRangeSets_EventRanges",
+                 {"RangeSetsID INTEGER",
+                  "EventRangesID INTEGER",
+                  "PRIMARY KEY(RangeSetsID,EventRangesID)"},
+                 "WITHOUT ROWID");
+  }
+
+  RangeSetWriter::RangeSetWriter(sqlite3* db) : db_{db}
+  {
+    insertEventRange_ = prepare(db_,
+                                "INSERT INTO EventRanges(rowid, SubRun, "
+                                "begin, end) VALUES(?,?,?,?);");
+    for (auto const bt : {InSubRun, InRun}) {
+      auto const prefix = BranchTypeToString(bt) + "RangeSets";
+      auto& t = tables_[bt];
+      t.insertRangeSet =
+        prepare(db_, "INSERT INTO " + prefix + "(rowid, Run) VALUES(?,?);");
+      t.insertJoin = prepare(db_,
+                             "INSERT OR IGNORE INTO " + prefix +
+                               "_EventRanges(RangeSetsID, EventRangesID) "
+                               "VALUES(?,?);");
+    }
+  }
+
+  RangeSetWriter::~RangeSetWriter()
+  {
+    sqlite3_finalize(insertEventRange_);
+    for (auto const& t : tables_) {
+      sqlite3_finalize(t.insertRangeSet);
+      sqlite3_finalize(t.insertJoin);
+    }
+  }
+
+  RangeSetWriter::Tables&
+  RangeSetWriter::tables(BranchType const bt)
+  {
+    if (!range_sets_supported(bt)) {
+      throw Exception{errors::LogicError}
+        << "RangeSets cannot be written for branch type "
+        << BranchTypeToString(bt) << ".\n";
+    }
+    return tables_[bt];
+  }
+
+  unsigned
+  RangeSetWriter::rangeSetID(BranchType const bt, RangeSet const& rs)
+  {
+    auto& t = tables(bt);
+    auto& candidates = t.idsByChecksum[rs.checksum()];
+    for (auto const& [seen, id] : candidates) {
+      if (seen == rs) {
+        return id;
+      }
+    }
+    while (t.importedIDs.count(t.nextID) != 0) {
+      ++t.nextID;
+    }
+    auto const id = t.nextID++;
+    candidates.emplace_back(rs, id);
+    t.pending.emplace_back(id, rs);
+    return id;
+  }
+
+  bool
+  RangeSetWriter::import(
+    BranchType const bt,
+    std::vector<std::pair<unsigned, RangeSet>> const& rangeSets)
+  {
+    auto& t = tables(bt);
+    std::map<unsigned, RangeSet const*> known;
+    for (auto const& [checksum, candidates] : t.idsByChecksum) {
+      for (auto const& [rs, id] : candidates) {
+        known.emplace(id, &rs);
+      }
+    }
+    for (auto const& [id, rs] : rangeSets) {
+      auto const it = known.find(id);
+      if (it != known.cend() && !(*it->second == rs)) {
+        return false;
+      }
+    }
+    for (auto const& [id, rs] : rangeSets) {
+      if (known.count(id) != 0) {
+        continue;
+      }
+      t.importedIDs.insert(id);
+      t.idsByChecksum[rs.checksum()].emplace_back(rs, id);
+      t.pending.emplace_back(id, rs);
+    }
+    return true;
+  }
+
+  unsigned
+  RangeSetWriter::eventRangeID(EventRange const& range)
+  {
+    auto const [it, inserted] = eventRangeIDs_.try_emplace(
+      EventRangeKey{range.subRun(), range.begin(), range.end()},
+      eventRangeIDs_.size() + 1);
+    if (inserted) {
+      insert_row(db_,
+                 insertEventRange_,
+                 it->second,
+                 range.subRun(),
+                 range.begin(),
+                 range.end());
+    }
+    return it->second;
+  }
+
+  void
+  RangeSetWriter::flush()
+  {
+    cet::sqlite::Transaction txn{db_};
+    for (auto const bt : {InSubRun, InRun}) {
+      auto& t = tables_[bt];
+      for (auto const& [id, rs] : t.pending) {
+        insert_row(db_, t.insertRangeSet, id, rs.run());
+        for (auto const& range : rs) {
+          insert_row(db_, t.insertJoin, id, eventRangeID(range));
+        }
+      }
+      t.pending.clear();
+    }
+    txn.commit();
+  }
+
+} // namespace art::detail
@@ -0,0 +1,87 @@
+#ifndef art_root_io_detail_RangeSetWriter_h
+#define art_root_io_detail_RangeSetWriter_h
+
+// ======================================================================
+// RangeSetWriter
+//
+// Writes the Run and SubRun RangeSets of one output file to its
+// RootFileDB.  The RangeSet tables, created beforehand with
+// createTables(), are filled with statements prepared once for the
+// lifetime of the writer, which must not outlive the database
+// connection.
+//
+// IDs are assigned in memory as RangeSets are requested, and a
+// RangeSet that is equal to one already seen in the file reuses its
+// ID.  The rows for the newly assigned IDs are written by flush() in a
+// single transaction.
+// ======================================================================
+
+#include "canvas/Persistency/Provenance/BranchType.h"
+#include "canvas/Persistency/Provenance/IDNumber.h"
+#include "canvas/Persistency/Provenance/RangeSet.h"
+
+#include <array>
+#include <map>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace art::detail {
+
+  class RangeSetWriter {
+  public:
+    // (Re)creates the empty RangeSet tables.
+    static void createTables(sqlite3* db);
+
+    explicit RangeSetWriter(sqlite3* db);
+    ~RangeSetWriter();
+
+    RangeSetWriter(RangeSetWriter const&) = delete;
+    RangeSetWriter& operator=(RangeSetWriter const&) = delete;
+
+    // Only BranchTypes that support RangeSets (InSubRun, InRun) are
+    // allowed.
+    unsigned rangeSetID(BranchType, RangeSet const&);
+    // Records the RangeSets under the given IDs, as needed for
+    // products that are copied from another file without being
+    // rewritten.  Nothing is recorded, and false is returned, if any
+    // of the IDs already stands for a different RangeSet.
+    bool import(BranchType,
+                std::vector<std::pair<unsigned, RangeSet>> const& rangeSets);
+    void flush();
+
+  private:
+    using EventRangeKey =
+      std::tuple<SubRunNumber_t, EventNumber_t, EventNumber_t>;
+
+    struct Tables {
+      sqlite3_stmt* insertRangeSet{nullptr};
+      sqlite3_stmt* insertJoin{nullptr};
+      unsigned nextID{1u};
+      std::map<unsigned, std::vector<std::pair<RangeSet, unsigned>>>
+        idsByChecksum{};
+      // Imported IDs are skipped when assigning new ones.
+      std::set<unsigned> importedIDs{};
+      std::vector<std::pair<unsigned, RangeSet>> pending{};
+    };
+
+    Tables& tables(BranchType);
+    unsigned eventRangeID(EventRange const&);
+
+    sqlite3* db_;
+    sqlite3_stmt* insertEventRange_{nullptr};
+    std::map<EventRangeKey, unsigned> eventRangeIDs_{};
+    std::array<Tables, NumBranchTypes> tables_{};
+  };
+
+} // namespace art::detail
+
+#endif /* art_root_io_detail_RangeSetWriter_h */
+
+// Local variables:
+// mode: c++
+// End:
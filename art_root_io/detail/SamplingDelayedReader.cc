@@ -12,7 +12,6 @@
 #include "canvas_root_io/Streamers/RefCoreStreamer.h"
 
 #include "TBranch.h"
-#include "TClass.h"
 
 #include <cassert>
 
@@ -67,12 +66,11 @@ namespace art::detail {
   {
     auto const& pd = g->productDescription();
     assert(pd.productID() == pid);
-    return getProduct(pid, pd.wrappedName(), rs);
+    return getProduct(pid, rs);
   }
 
   unique_ptr<EDProduct>
   SamplingDelayedReader::getProduct(ProductID const productID,
-                                    std::string const& wrapped_class_name,
                                     RangeSet& rs) const
   {
     auto iter = branches_.find(productID);
@@ -85,10 +83,9 @@ namespace art::detail {
     InputSourceMutexSentry sentry;
     configureProductIDStreamer(branchIDLists_);
     configureRefCoreStreamer(principal_.get());
-    TClass* cl{TClass::GetClass(wrapped_class_name.c_str())};
 
-    auto get_product = [this, cl, br](auto entry) {
-      unique_ptr<EDProduct> p{static_cast<EDProduct*>(cl->New())};
+    auto get_product = [this, br, &branchInfo](auto entry) {
+      unique_ptr<EDProduct> p{branchInfo.newProduct()};
       EDProduct* pp{p.get()};
       br->SetAddress(&pp);
       auto const bytesRead = input::getEntry(br, entry);
@@ -37,9 +37,7 @@ namespace art::detail {
                           EventID const& id,
                           bool compactSubRunRanges);
 
-    std::unique_ptr<EDProduct> getProduct(ProductID,
-                                          std::string const& wrappedType,
-                                          RangeSet&) const;
+    std::unique_ptr<EDProduct> getProduct(ProductID, RangeSet&) const;
 
   private:
     std::unique_ptr<EDProduct> getProduct_(Group const*,
@@ -26,8 +26,10 @@
 #include "messagefacility/MessageLogger/MessageLogger.h"
 #include "range/v3/view.hpp"
 
+#include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 using EntriesForID_t = art::detail::SamplingInputFile::EntriesForID_t;
 using ProductsForKey_t = art::detail::SamplingInputFile::ProductsForKey_t;
@@ -322,7 +324,7 @@ namespace art::detail {
         if (bd.branchType() != bt)
           continue;
         auto rs = RangeSet::invalid();
-        auto product = reader.getProduct(bd.productID(), bd.wrappedName(), rs);
+        auto product = reader.getProduct(bd.productID(), rs);
         result[key].emplace(id.subRunID(), std::move(product));
       }
     }
@@ -418,8 +420,10 @@ namespace art::detail {
         }
       }
     }
-    // On this pass, actually drop the branches.
+    // On this pass, actually drop the branches, all at once for each
+    // tree.
     auto branchesToDropEnd = branchesToDrop.cend();
+    std::map<TTree*, std::vector<std::string>> branchNames;
     for (auto I = descriptions.begin(), E = descriptions.end(); I != E;) {
       auto const& pd = I->second;
       bool drop = branchesToDrop.find(pd.productID()) != branchesToDropEnd;
@@ -436,10 +440,14 @@ namespace art::detail {
           << "' because it is dependent on a branch\n"
           << "that was explicitly dropped.\n";
       }
-      dropBranch(treeForBranchType_(pd.branchType()), pd.branchName());
+      branchNames[treeForBranchType_(pd.branchType())].push_back(
+        pd.branchName());
       auto icopy = I++;
       descriptions.erase(icopy);
     }
+    for (auto const& [tree, names] : branchNames) {
+      dropBranches(tree, names);
+    }
   }
 
   TTree*
@@ -6,30 +6,54 @@
 #include "TObjArray.h"
 #include "TTree.h"
 
+#include <string_view>
+#include <unordered_set>
+
 void
 art::detail::dropBranch(TTree* tree, std::string const& branchName)
 {
-  TBranch* branch = tree->GetBranch(branchName.c_str());
-  if (!branch) {
+  dropBranches(tree, {branchName});
+}
+
+void
+art::detail::dropBranches(TTree* tree,
+                          std::vector<std::string> const& branchNames)
+{
+  if (branchNames.empty()) {
     return;
   }
-  TObjArray* leaves = tree->GetListOfLeaves();
-  int entries = leaves->GetEntries();
-  for (int i = 0; i < entries; ++i) {
-    auto leaf = reinterpret_cast<TLeaf*>((*leaves)[i]);
-    if (leaf == nullptr) {
-      continue;
-    }
-    TBranch* br = leaf->GetBranch();
-    if (br == nullptr) {
-      continue;
+  std::unordered_set<std::string_view> const names(branchNames.cbegin(),
+                                                   branchNames.cend());
+
+  TObjArray* branches = tree->GetListOfBranches();
+  std::unordered_set<TBranch*> toDrop;
+  for (int i = 0, n = branches->GetEntriesFast(); i != n; ++i) {
+    auto branch = static_cast<TBranch*>(branches->UncheckedAt(i));
+    if (branch != nullptr && names.count(branch->GetName()) != 0) {
+      toDrop.insert(branch);
+      branches->RemoveAt(i);
     }
-    if (br->GetMother() == branch) {
-      leaves->Remove(leaf);
+  }
+  if (toDrop.empty()) {
+    return;
+  }
+  branches->Compress();
+
+  if (TObjArray* leaves = tree->GetListOfLeaves()) {
+    for (int i = 0, n = leaves->GetEntriesFast(); i != n; ++i) {
+      auto leaf = static_cast<TLeaf*>(leaves->UncheckedAt(i));
+      if (leaf == nullptr) {
+        continue;
+      }
+      TBranch* br = leaf->GetBranch();
+      if (br != nullptr && toDrop.count(br->GetMother()) != 0) {
+        leaves->RemoveAt(i);
+      }
     }
+    leaves->Compress();
+  }
+
+  for (auto branch : toDrop) {
+    delete branch;
   }
-  leaves->Compress();
-  tree->GetListOfBranches()->Remove(branch);
-  tree->GetListOfBranches()->Compress();
-  delete branch;
 }
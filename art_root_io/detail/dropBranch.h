@@ -4,9 +4,15 @@
 class TTree;
 
 #include <string>
+#include <vector>
 
 namespace art::detail {
   void dropBranch(TTree* tree, std::string const& branchName);
+
+  // Removes all of the named top-level branches, and their leaves,
+  // from the tree in a single pass over its lists of branches and
+  // leaves.  Names that do not match a branch are ignored.
+  void dropBranches(TTree* tree, std::vector<std::string> const& branchNames);
 }
 
 #endif /* art_root_io_detail_dropBranch_h */
@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////
+// event_index_builder
+//
+// Record, in an SQLite event index, which of the specified art/ROOT
+// files contains each event, using the files' FileIndex.  RootInput
+// consults the index (see its 'eventIndex' parameter) to open exactly
+// one file when seeking to an event in a file it has not yet opened.
+//
+// The file names are recorded as given; they must match the names by
+// which the files are given to RootInput.
+////////////////////////////////////////////////////////////////////////
+
+#include "art_root_io/detail/EventIndexDB.h"
+#include "art_root_io/detail/readFileIndex.h"
+#include "canvas/Persistency/Provenance/FileIndex.h"
+#include "canvas/Persistency/Provenance/rootNames.h"
+#include "cetlib/parsed_program_options.h"
+
+#include "boost/program_options.hpp"
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "TError.h"
+#include "TFile.h"
+#include "TTree.h"
+
+namespace bpo = boost::program_options;
+
+namespace {
+  bool
+  index_file(std::string const& fileName,
+             art::detail::EventIndexWriter& writer,
+             std::ostream& err)
+  {
+    // Ignore less severe warnings for the purposes of opening the file.
+    auto savedErrorLevel = gErrorIgnoreLevel;
+    gErrorIgnoreLevel = kBreak;
+    std::unique_ptr<TFile> tf{TFile::Open(fileName.c_str())};
+    gErrorIgnoreLevel = savedErrorLevel;
+    if (tf.get() == nullptr || tf->IsZombie()) {
+      err << fileName << "\tCould not be opened by ROOT: skipped.\n";
+      return false;
+    }
+    std::unique_ptr<TTree> metaDataTree{
+      tf->Get<TTree>(art::rootNames::metaDataTreeName().c_str())};
+    if (!metaDataTree) {
+      err << fileName << "\tNot a valid art ROOT-format file: skipped.\n";
+      return false;
+    }
+    try {
+      art::FileIndex fileIndex;
+      auto fileIndexPtr = &fileIndex;
+      art::detail::readFileIndex(tf.get(), metaDataTree.get(), fileIndexPtr);
+      writer.addFile(fileName, std::move(fileIndex));
+    }
+    catch (std::exception const& e) {
+      err << fileName << "\tCould not be indexed: skipped.\n" << e.what();
+      return false;
+    }
+    return true;
+  }
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  using stringvec = std::vector<std::string>;
+  std::ostringstream descstr;
+  descstr << argv[0] << " [<options>] -o <index> <filename>+\nOptions";
+  bpo::options_description desc(descstr.str());
+  // clang-format off
+  desc.add_options()
+    ("help,h", "this help message.")
+    ("output,o", bpo::value<std::string>(),
+       "event index to create or update (SQLite database).")
+    ("source,s",
+       bpo::value<stringvec>()->composing(), "source data file (multiple OK).");
+  // clang-format on
+
+  bpo::options_description all_opts("All Options.");
+  all_opts.add(desc);
+
+  // Each non-option argument is interpreted as the name of a file to be
+  // processed. Any number of filenames is allowed.
+  bpo::positional_options_description pd;
+  pd.add("source", -1);
+
+  auto const vm = cet::parsed_program_options(argc, argv, all_opts, pd);
+
+  if (vm.count("help")) {
+    std::cerr << desc << std::endl;
+    return 1;
+  }
+  if (vm.count("output") == 0) {
+    std::cerr << "Require the name of the event index.\n";
+    std::cerr << desc << "\n";
+    return 1;
+  }
+  if (vm.count("source") == 0) {
+    std::cerr << "Require at least one source file.\n";
+    std::cerr << desc << "\n";
+    return 1;
+  }
+  auto const& sources = vm["source"].as<stringvec>();
+  std::size_t failed{};
+  try {
+    art::detail::EventIndexWriter writer{vm["output"].as<std::string>()};
+    for (auto const& source : sources) {
+      if (!index_file(source, writer, std::cerr)) {
+        ++failed;
+      }
+    }
+  }
+  catch (std::exception const& e) {
+    std::cerr << e.what();
+    return 1;
+  }
+  if (failed != 0) {
+    std::cout << "Failed to index " << failed << " of " << sources.size()
+              << " specified files." << std::endl;
+    return 1;
+  }
+  std::cout << "Indexed events of " << sources.size() << " specified files."
+            << std::endl;
+  return 0;
+}
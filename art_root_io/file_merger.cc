@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////
+// file_merger
+//
+// Concatenate art/ROOT files into one, without running an art job:
+// the baskets of the data trees are copied as they are, and the
+// metadata of the files (FileIndex, products, process histories,
+// parentage, ParameterSets and RangeSets) are merged.  See
+// art_root_io/detail/FileMerger.h for the files that can be merged.
+////////////////////////////////////////////////////////////////////////
+
+#include "art_root_io/detail/FileMerger.h"
+#include "cetlib/parsed_program_options.h"
+
+#include "boost/program_options.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bpo = boost::program_options;
+
+int
+main(int argc, char** argv)
+{
+  using stringvec = std::vector<std::string>;
+  std::ostringstream descstr;
+  descstr << argv[0] << " [<options>] -o <output> <filename>+\nOptions";
+  bpo::options_description desc(descstr.str());
+  // clang-format off
+  desc.add_options()
+    ("help,h", "this help message.")
+    ("output,o", bpo::value<std::string>(), "merged file to create.")
+    ("compression-level,c", bpo::value<int>()->default_value(7),
+       "compression level of the baskets that are not copied as they are.")
+    ("look-ahead,j", bpo::value<unsigned>()->default_value(2u),
+       "number of input files opened at a time.")
+    ("source,s",
+       bpo::value<stringvec>()->composing(), "source data file (multiple OK).");
+  // clang-format on
+
+  bpo::options_description all_opts("All Options.");
+  all_opts.add(desc);
+
+  // Each non-option argument is interpreted as the name of a file to be
+  // merged. Any number of filenames is allowed.
+  bpo::positional_options_description pd;
+  pd.add("source", -1);
+
+  auto const vm = cet::parsed_program_options(argc, argv, all_opts, pd);
+
+  if (vm.count("help")) {
+    std::cerr << desc << std::endl;
+    return 1;
+  }
+  if (vm.count("output") == 0) {
+    std::cerr << "Require the name of the merged file.\n";
+    std::cerr << desc << "\n";
+    return 1;
+  }
+  if (vm.count("source") == 0) {
+    std::cerr << "Require at least one source file.\n";
+    std::cerr << desc << "\n";
+    return 1;
+  }
+  auto const& output = vm["output"].as<std::string>();
+  auto const& sources = vm["source"].as<stringvec>();
+  try {
+    art::detail::FileMerger merger{output,
+                                   vm["compression-level"].as<int>(),
+                                   vm["look-ahead"].as<unsigned>()};
+    merger.merge(sources, std::cout);
+    merger.close();
+  }
+  catch (std::exception const& e) {
+    std::cerr << e.what();
+    // Do not leave an incomplete file behind.
+    std::remove(output.c_str());
+    return 1;
+  }
+  std::cout << "Merged " << sources.size() << " specified files into "
+            << output << '.' << std::endl;
+  return 0;
+}
@@ -0,0 +1,44 @@
+#include "art_root_io/Inputfwd.h"
+#include "canvas/Persistency/Provenance/BranchDescription.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using art::BranchDescription;
+using art::ProductID;
+using art::input::BranchInfo;
+using art::input::BranchMap;
+
+TEST_CASE("Branches are found by product ID")
+{
+  std::vector<BranchDescription> const descriptions(4);
+  BranchMap branches;
+  std::vector<unsigned> const ids{42u, 7u, 1000u, 13u};
+  for (std::size_t i = 0; i != ids.size(); ++i) {
+    branches.emplace(ProductID{ids[i]}, BranchInfo{descriptions[i], nullptr});
+  }
+  REQUIRE(branches.size() == ids.size());
+  for (std::size_t i = 0; i != ids.size(); ++i) {
+    auto const it = branches.find(ProductID{ids[i]});
+    REQUIRE(it != branches.end());
+    CHECK(it->first == ProductID{ids[i]});
+    CHECK(&it->second.branchDescription_ == &descriptions[i]);
+  }
+  CHECK(branches.find(ProductID{8u}) == branches.end());
+  CHECK(branches.find(ProductID{2000u}) == branches.end());
+}
+
+TEST_CASE("Branches keep the order in which they were added")
+{
+  std::vector<BranchDescription> const descriptions(3);
+  BranchMap branches;
+  branches.emplace(ProductID{3u}, BranchInfo{descriptions[0], nullptr});
+  branches.emplace(ProductID{1u}, BranchInfo{descriptions[1], nullptr});
+  branches.emplace(ProductID{3u}, BranchInfo{descriptions[2], nullptr});
+  REQUIRE(branches.size() == 2u);
+  auto it = branches.begin();
+  CHECK(it->first == ProductID{3u});
+  CHECK(&it->second.branchDescription_ == &descriptions[0]);
+  ++it;
+  CHECK(it->first == ProductID{1u});
+}
@@ -0,0 +1,50 @@
+#include "art_root_io/detail/CompressionRules.h"
+
+#include "Compression.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+using art::detail::CompressionRules;
+
+TEST_CASE("The first matching rule applies")
+{
+  CompressionRules rules;
+  rules.add("recob*_*_*_Reco", "LZ4", 4);
+  rules.add("*_daq", "LZMA", 9);
+  rules.add("*_*_?", "ZSTD", 5);
+  REQUIRE(rules.size() == 3);
+
+  CHECK(rules.match("recobHits", "gaushit", "", "Reco") == 0u);
+  CHECK(rules.match("recobHits", "daq", "", "Reco") == 0u);
+  CHECK(rules.match("rawRawDigits", "daq", "", "Detsim") == 1u);
+  CHECK(rules.match("recobTracks", "pandora", "a", "Reco2") == 2u);
+  CHECK_FALSE(rules.match("recobTracks", "pandora", "ab", "Reco2"));
+  CHECK_FALSE(rules.match("recobTracks", "pandora", "", "Reco2"));
+}
+
+TEST_CASE("Rules carry ROOT compression settings")
+{
+  CompressionRules rules;
+  rules.add("*", "ZLIB", 1);
+  rules.add("*", "LZ4", 4);
+  rules.add("*", "ZSTD", 0);
+  CHECK(rules.settings(0) ==
+        ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kZLIB,
+                                  1));
+  CHECK(rules.settings(1) ==
+        ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kLZ4,
+                                  4));
+  CHECK(rules[1].algorithm == "LZ4");
+  CHECK(rules[1].level == 4);
+  CHECK(rules.settings(2) == 500);
+}
+
+TEST_CASE("Malformed rules are rejected")
+{
+  CompressionRules rules;
+  CHECK_THROWS(rules.add("a_b_c_d_e", "LZ4", 4));
+  CHECK_THROWS(rules.add("*", "BZIP2", 4));
+  CHECK_THROWS(rules.add("*", "LZ4", 10));
+  CHECK_THROWS(rules.add("*", "LZ4", -1));
+  CHECK(rules.empty());
+}
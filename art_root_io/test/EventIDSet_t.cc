@@ -0,0 +1,96 @@
+#include "art_root_io/detail/EventIDSet.h"
+#include "canvas/Persistency/Provenance/FileIndex.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using art::EventID;
+using art::FileIndex;
+using art::detail::EventIDSet;
+
+namespace {
+  FileIndex
+  makeIndex(unsigned const run,
+            unsigned const subRun,
+            std::vector<unsigned> const& events)
+  {
+    FileIndex result;
+    FileIndex::EntryNumber_t entry{};
+    for (auto const event : events) {
+      result.addEntry(EventID{run, subRun, event}, entry++);
+    }
+    result.sortBy_Run_SubRun_Event();
+    return result;
+  }
+}
+
+TEST_CASE("Reserved events are inserted once")
+{
+  EventIDSet ids;
+  ids.reserve(makeIndex(1, 1, {1, 2, 3, 5}));
+  CHECK(ids.insert(EventID{1, 1, 2}));
+  CHECK(ids.insert(EventID{1, 1, 5}));
+  CHECK_FALSE(ids.insert(EventID{1, 1, 2}));
+  CHECK(ids.insert(EventID{1, 1, 3}));
+  CHECK_FALSE(ids.insert(EventID{1, 1, 5}));
+}
+
+TEST_CASE("Subruns and runs are distinguished")
+{
+  EventIDSet ids;
+  ids.reserve(makeIndex(1, 1, {1, 2}));
+  ids.reserve(makeIndex(1, 2, {1, 2}));
+  ids.reserve(makeIndex(2, 1, {1, 2}));
+  CHECK(ids.insert(EventID{1, 1, 1}));
+  CHECK(ids.insert(EventID{1, 2, 1}));
+  CHECK(ids.insert(EventID{2, 1, 1}));
+  CHECK_FALSE(ids.insert(EventID{1, 2, 1}));
+  CHECK_FALSE(ids.insert(EventID{1, 1, 1}));
+}
+
+TEST_CASE("Events of later files extend a subrun")
+{
+  EventIDSet ids;
+  ids.reserve(makeIndex(1, 1, {100, 101}));
+  CHECK(ids.insert(EventID{1, 1, 100}));
+  CHECK(ids.insert(EventID{1, 1, 101}));
+  ids.reserve(makeIndex(1, 1, {50, 101, 150}));
+  CHECK(ids.insert(EventID{1, 1, 50}));
+  CHECK_FALSE(ids.insert(EventID{1, 1, 101}));
+  CHECK(ids.insert(EventID{1, 1, 150}));
+  CHECK_FALSE(ids.insert(EventID{1, 1, 100}));
+}
+
+TEST_CASE("Sparse and unreserved event numbers")
+{
+  EventIDSet ids;
+  ids.reserve(makeIndex(1, 1, {1, 4000000000u}));
+  CHECK(ids.insert(EventID{1, 1, 4000000000u}));
+  CHECK(ids.insert(EventID{1, 1, 1}));
+  CHECK_FALSE(ids.insert(EventID{1, 1, 4000000000u}));
+  // Not listed in any index.
+  CHECK(ids.insert(EventID{1, 1, 7}));
+  CHECK(ids.insert(EventID{3, 1, 7}));
+  CHECK_FALSE(ids.insert(EventID{1, 1, 7}));
+  CHECK_FALSE(ids.insert(EventID{3, 1, 7}));
+}
+
+TEST_CASE("A dense subrun becomes sparse")
+{
+  EventIDSet ids;
+  ids.reserve(makeIndex(1, 1, {1, 2, 3}));
+  CHECK(ids.insert(EventID{1, 1, 2}));
+  ids.reserve(makeIndex(1, 1, {3000000000u}));
+  CHECK_FALSE(ids.insert(EventID{1, 1, 2}));
+  CHECK(ids.insert(EventID{1, 1, 3000000000u}));
+  CHECK(ids.insert(EventID{1, 1, 3}));
+}
+
+TEST_CASE("Clearing forgets all events")
+{
+  EventIDSet ids;
+  ids.reserve(makeIndex(1, 1, {1}));
+  CHECK(ids.insert(EventID{1, 1, 1}));
+  ids.clear();
+  CHECK(ids.insert(EventID{1, 1, 1}));
+}
@@ -0,0 +1,77 @@
+#include "art_root_io/detail/EventIndexDB.h"
+#include "canvas/Persistency/Provenance/FileIndex.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using art::EventID;
+using art::FileIndex;
+using art::detail::EventIndexReader;
+using art::detail::EventIndexWriter;
+
+namespace {
+  FileIndex
+  makeIndex(std::vector<EventID> const& events)
+  {
+    FileIndex result;
+    FileIndex::EntryNumber_t entry{};
+    for (auto const& id : events) {
+      result.addEntry(id, entry++);
+    }
+    return result;
+  }
+
+  std::string
+  freshIndex(std::string const& name)
+  {
+    std::remove(name.c_str());
+    return name;
+  }
+}
+
+TEST_CASE("Events are found in the file that holds them")
+{
+  auto const indexName = freshIndex("EventIndexDB_t_01.db");
+  {
+    EventIndexWriter writer{indexName};
+    writer.addFile("a.root",
+                   makeIndex({EventID{1, 1, 3},
+                              EventID{1, 1, 1},
+                              EventID{1, 1, 2},
+                              EventID{1, 2, 1}}));
+    writer.addFile("b.root",
+                   makeIndex({EventID{1, 1, 4}, EventID{1, 1, 10}}));
+  }
+  EventIndexReader const reader{indexName};
+  CHECK(reader.fileContaining(EventID{1, 1, 1}) == "a.root");
+  CHECK(reader.fileContaining(EventID{1, 1, 3}) == "a.root");
+  CHECK(reader.fileContaining(EventID{1, 2, 1}) == "a.root");
+  CHECK(reader.fileContaining(EventID{1, 1, 4}) == "b.root");
+  CHECK(reader.fileContaining(EventID{1, 1, 10}) == "b.root");
+  CHECK_FALSE(reader.fileContaining(EventID{1, 1, 5}).has_value());
+  CHECK_FALSE(reader.fileContaining(EventID{2, 1, 1}).has_value());
+  CHECK_FALSE(reader.fileContaining(EventID{}).has_value());
+}
+
+TEST_CASE("Indexing a file again replaces its entries")
+{
+  auto const indexName = freshIndex("EventIndexDB_t_02.db");
+  {
+    EventIndexWriter writer{indexName};
+    writer.addFile("a.root", makeIndex({EventID{1, 1, 1}}));
+  }
+  {
+    EventIndexWriter writer{indexName};
+    writer.addFile("a.root", makeIndex({EventID{1, 1, 2}}));
+  }
+  EventIndexReader const reader{indexName};
+  CHECK_FALSE(reader.fileContaining(EventID{1, 1, 1}).has_value());
+  CHECK(reader.fileContaining(EventID{1, 1, 2}) == "a.root");
+}
+
+TEST_CASE("A missing index cannot be read")
+{
+  CHECK_THROWS(EventIndexReader{"no_such_directory/index.db"});
+}
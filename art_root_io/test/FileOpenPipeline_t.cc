@@ -0,0 +1,72 @@
+#include "art_root_io/detail/FileOpenPipeline.h"
+#include "canvas/Persistency/Provenance/rootNames.h"
+
+#include "TFile.h"
+#include "TROOT.h"
+#include "TTree.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+using art::detail::FileOpenPipeline;
+
+namespace {
+  std::string
+  makeFile(std::string const& name)
+  {
+    ROOT::EnableThreadSafety();
+    TFile file{name.c_str(), "RECREATE"};
+    TTree tree{art::rootNames::metaDataTreeName().c_str(), ""};
+    int value{};
+    tree.Branch("value", &value);
+    tree.Fill();
+    file.Write();
+    return name;
+  }
+
+  std::vector<std::string> const fileNames{makeFile("pipeline_a.root"),
+                                           makeFile("pipeline_b.root"),
+                                           makeFile("pipeline_c.root")};
+}
+
+TEST_CASE("Look-ahead depth is bounded")
+{
+  FileOpenPipeline pipeline{2};
+  pipeline.schedule(fileNames);
+  CHECK(pipeline.pending() == 2ull);
+  pipeline.schedule(fileNames);
+  CHECK(pipeline.pending() == 2ull);
+}
+
+TEST_CASE("Files are handed out opened, with metadata loaded")
+{
+  FileOpenPipeline pipeline{3};
+  pipeline.schedule(fileNames);
+  auto file = pipeline.take(fileNames[1]);
+  REQUIRE(file.has_value());
+  REQUIRE(*file);
+  CHECK((*file)->GetName() == fileNames[1]);
+  auto tree = (*file)->Get<TTree>(art::rootNames::metaDataTreeName().c_str());
+  REQUIRE(tree != nullptr);
+  CHECK(tree->GetEntries() == 1);
+  // The file scheduled before the one taken was discarded.
+  CHECK(pipeline.pending() == 1ull);
+}
+
+TEST_CASE("Taking a file that was not scheduled cancels the pipeline")
+{
+  FileOpenPipeline pipeline{3};
+  pipeline.schedule(fileNames);
+  CHECK_FALSE(pipeline.take("pipeline_d.root").has_value());
+  CHECK(pipeline.pending() == 0ull);
+}
+
+TEST_CASE("A file that cannot be opened is handed out as null")
+{
+  FileOpenPipeline pipeline{1};
+  pipeline.schedule({"no_such_directory/pipeline.root"});
+  auto file = pipeline.take("no_such_directory/pipeline.root");
+  REQUIRE(file.has_value());
+  CHECK_FALSE(*file);
+}
@@ -0,0 +1,50 @@
+// ======================================================================
+// Reads the products made by IOBenchmarkProducer, used to exercise
+// art/ROOT I/O in the benchmark tests.
+// ======================================================================
+
+#include "art/Framework/Core/SharedAnalyzer.h"
+#include "art/Framework/Principal/Event.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace art::test {
+
+  class IOBenchmarkAnalyzer : public SharedAnalyzer {
+  public:
+    struct Config {
+      fhicl::Atom<std::string> moduleLabel{fhicl::Name{"moduleLabel"}};
+      fhicl::Atom<unsigned> nProducts{fhicl::Name{"nProducts"}, 100u};
+    };
+    using Parameters = Table<Config>;
+
+    explicit IOBenchmarkAnalyzer(Parameters const& p, ProcessingFrame const&)
+      : SharedAnalyzer{p}
+    {
+      async<InEvent>();
+      for (unsigned i = 0; i != p().nProducts(); ++i) {
+        tags_.emplace_back(p().moduleLabel(), "p" + std::to_string(i));
+        consumes<std::vector<double>>(tags_.back());
+      }
+    }
+
+  private:
+    void
+    analyze(Event const& e, ProcessingFrame const&) override
+    {
+      double const value = e.event();
+      for (unsigned i = 0; i != tags_.size(); ++i) {
+        auto const& prod = *e.getValidHandle<std::vector<double>>(tags_[i]);
+        assert(prod.empty() || prod.front() == value + i);
+      }
+    }
+
+    std::vector<InputTag> tags_{};
+  };
+}
+
+DEFINE_ART_MODULE(art::test::IOBenchmarkAnalyzer)
@@ -0,0 +1,59 @@
+// ======================================================================
+// Produces a configurable number of std::vector<double> instances per
+// event, used to exercise art/ROOT I/O in the benchmark tests.
+// ======================================================================
+
+#include "art/Framework/Core/SharedProducer.h"
+#include "art/Framework/Principal/Event.h"
+#include "fhiclcpp/types/Atom.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace art::test {
+
+  class IOBenchmarkProducer : public SharedProducer {
+  public:
+    struct Config {
+      fhicl::Atom<unsigned> nProducts{fhicl::Name{"nProducts"}, 100u};
+      fhicl::Atom<unsigned> productSize{fhicl::Name{"productSize"}, 1000u};
+    };
+    using Parameters = Table<Config>;
+    explicit IOBenchmarkProducer(Parameters const& p, ProcessingFrame const&)
+      : SharedProducer{p}
+      , nProducts_{p().nProducts()}
+      , productSize_{p().productSize()}
+    {
+      async<InEvent>();
+      for (unsigned i = 0; i != nProducts_; ++i) {
+        produces<std::vector<double>>(instanceName(i));
+      }
+    }
+
+    static std::string
+    instanceName(unsigned const i)
+    {
+      return "p" + std::to_string(i);
+    }
+
+  private:
+    void
+    produce(Event& e, ProcessingFrame const&) override
+    {
+      double const value = e.event();
+      for (unsigned i = 0; i != nProducts_; ++i) {
+        auto p = std::make_unique<std::vector<double>>(productSize_);
+        for (std::size_t k = 0; k != productSize_; ++k) {
+          (*p)[k] = value + i + 0.001 * k;
+        }
+        e.put(std::move(p), instanceName(i));
+      }
+    }
+
+    unsigned const nProducts_;
+    unsigned const productSize_;
+  };
+}
+
+DEFINE_ART_MODULE(art::test::IOBenchmarkProducer)
@@ -0,0 +1,29 @@
+// ======================================================================
+// Enables ROOT's implicit multi-threading, with the number of threads
+// of the art job, for the tests of options that require the job to
+// enable it.
+// ======================================================================
+
+#include "art/Framework/Services/Registry/ServiceDeclarationMacros.h"
+#include "art/Framework/Services/Registry/ServiceDefinitionMacros.h"
+#include "art/Framework/Services/Registry/ServiceTable.h"
+#include "art/Utilities/Globals.h"
+
+#include "TROOT.h"
+
+namespace arttest {
+  class ImplicitMT;
+}
+
+class arttest::ImplicitMT {
+public:
+  struct Config {};
+  using Parameters = art::ServiceTable<Config>;
+  explicit ImplicitMT(Parameters const&)
+  {
+    ROOT::EnableImplicitMT(art::Globals::instance()->nthreads());
+  }
+};
+
+DECLARE_ART_SERVICE(arttest::ImplicitMT, SHARED)
+DEFINE_ART_SERVICE(arttest::ImplicitMT)
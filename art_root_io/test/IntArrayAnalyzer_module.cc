@@ -18,20 +18,44 @@ namespace arttest {
 
 class arttest::IntArrayAnalyzer : public art::EDAnalyzer {
   art::ProductToken<IntArray<sz>> arrayToken_;
+  art::EventNumber_t firstEvent_;
+  bool increasingEventIDs_;
+  art::EventID lastEventID_{};
 
 public:
   struct Config {
     fhicl::Atom<std::string> moduleLabel{fhicl::Name{"moduleLabel"}};
+    fhicl::Atom<art::EventNumber_t> firstEvent{
+      fhicl::Name{"firstEvent"},
+      fhicl::Comment{"The product is neither read nor checked for the\n"
+                     "events numbered below 'firstEvent'."},
+      0u};
+    fhicl::Atom<bool> increasingEventIDs{
+      fhicl::Name{"increasingEventIDs"},
+      fhicl::Comment{"If 'increasingEventIDs' is true, the events must be\n"
+                     "seen in increasing EventID order."},
+      false};
   };
   using Parameters = Table<Config>;
 
   explicit IntArrayAnalyzer(Parameters const& p)
-    : art::EDAnalyzer{p}, arrayToken_{consumes<IntArray<sz>>(p().moduleLabel())}
+    : art::EDAnalyzer{p}
+    , arrayToken_{consumes<IntArray<sz>>(p().moduleLabel())}
+    , firstEvent_{p().firstEvent()}
+    , increasingEventIDs_{p().increasingEventIDs()}
   {}
 
   void
   analyze(art::Event const& e) override
   {
+    if (increasingEventIDs_) {
+      assert(!lastEventID_.isValid() || lastEventID_ < e.id());
+      lastEventID_ = e.id();
+    }
+    if (e.event() < firstEvent_) {
+      return;
+    }
+
     // Produce reference
     int const value = e.id().event();
     std::array<int, sz> ref{{}};
@@ -0,0 +1,99 @@
+// ======================================================================
+// Mixes the IntArray products of 'nSecondaries' secondary events into
+// each primary event, and checks that each product mixed is that of the
+// secondary event it was requested for: IntArrayProducer fills element
+// k of the array of event n with n + k.  The mixed product holds the
+// element-wise sums.
+// ======================================================================
+
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/IO/ProductMix/MixHelper.h"
+#include "art/Framework/Modules/MixFilter.h"
+#include "art/test/TestObjects/ToyProducts.h"
+#include "art_root_io/RootIOPolicy.h"
+#include "canvas/Persistency/Provenance/EventID.h"
+#include "canvas/Utilities/Exception.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/ParameterSet.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t sz{4u};
+}
+
+namespace arttest {
+  class MixIntArraysDetail;
+  class ListedFilesRootIOPolicy;
+  using MixIntArrays =
+    art::MixFilter<MixIntArraysDetail, ListedFilesRootIOPolicy>;
+}
+
+class arttest::MixIntArraysDetail {
+public:
+  MixIntArraysDetail(fhicl::ParameterSet const& ps, art::MixHelper& helper)
+    : nSecondaries_{ps.get<std::size_t>("nSecondaries")}
+  {
+    helper.declareMixOp(
+      art::InputTag{"arrays"}, &MixIntArraysDetail::mixArrays, *this);
+  }
+
+  std::size_t
+  nSecondaries() const
+  {
+    return nSecondaries_;
+  }
+
+  void
+  processEventIDs(art::EventIDSequence const& seq)
+  {
+    eventIDs_ = seq;
+  }
+
+  bool
+  mixArrays(std::vector<IntArray<sz> const*> const& in,
+            IntArray<sz>& out,
+            art::PtrRemapper const&)
+  {
+    if (in.size() != eventIDs_.size()) {
+      throw art::Exception{art::errors::LogicError}
+        << "MixIntArrays: " << in.size() << " products were mixed for "
+        << eventIDs_.size() << " secondary events.\n";
+    }
+    for (std::size_t k = 0; k != sz; ++k) {
+      out.arr[k] = 0;
+    }
+    for (std::size_t i = 0, n = in.size(); i != n; ++i) {
+      int const value = eventIDs_[i].event();
+      for (std::size_t k = 0; k != sz; ++k) {
+        if (in[i]->arr[k] != value + static_cast<int>(k)) {
+          throw art::Exception{art::errors::LogicError}
+            << "MixIntArrays: the product mixed for secondary event "
+            << eventIDs_[i] << " is not that of the event.\n";
+        }
+        out.arr[k] += in[i]->arr[k];
+      }
+    }
+    return true;
+  }
+
+private:
+  std::size_t const nSecondaries_;
+  art::EventIDSequence eventIDs_{};
+};
+
+// The secondary files of the mixIntArrays_*.fcl configurations, in the
+// order they are mixed, so that each file is pre-opened from the first
+// pass through them onward.  The event-tree cache is kept small.
+class arttest::ListedFilesRootIOPolicy : public art::RootIOPolicy {
+public:
+  ListedFilesRootIOPolicy()
+    : RootIOPolicy{{"../FastCloningRunsAndSubRuns_w1.d/out.root",
+                    "../FastCloningRunsAndSubRuns_w2.d/out.root",
+                    "../FileMerger_w3.d/out.root"},
+                   64 * 1024}
+  {}
+};
+
+DEFINE_ART_MODULE(arttest::MixIntArrays)
@@ -0,0 +1,87 @@
+#include "art_root_io/detail/RangeSetResolver.h"
+#include "canvas/Persistency/Provenance/EventRange.h"
+
+#include "sqlite3.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <limits>
+#include <vector>
+
+using art::EventRange;
+using art::InSubRun;
+using art::detail::RangeSetResolver;
+
+namespace {
+  class TestDB {
+  public:
+    TestDB()
+    {
+      sqlite3_open(":memory:", &db_);
+      exec("CREATE TABLE EventRanges(SubRun INTEGER, begin INTEGER, "
+           "end INTEGER);"
+           "CREATE TABLE SubRunRangeSets(Run INTEGER);"
+           "CREATE TABLE SubRunRangeSets_EventRanges(RangeSetsID INTEGER, "
+           "EventRangesID INTEGER);"
+           // RangeSet 1: run 3, subrun 1, events [1,4) and [4,7)
+           "INSERT INTO SubRunRangeSets(Run) VALUES(3);"
+           "INSERT INTO EventRanges VALUES(1,1,4);"
+           "INSERT INTO EventRanges VALUES(1,4,7);"
+           "INSERT INTO SubRunRangeSets_EventRanges VALUES(1,1);"
+           "INSERT INTO SubRunRangeSets_EventRanges VALUES(1,2);"
+           // RangeSet 2: run 4, subrun 2, events [10,12)
+           "INSERT INTO SubRunRangeSets(Run) VALUES(4);"
+           "INSERT INTO EventRanges VALUES(2,10,12);"
+           "INSERT INTO SubRunRangeSets_EventRanges VALUES(2,3);");
+    }
+    ~TestDB() { sqlite3_close(db_); }
+
+    void
+    exec(char const* ddl)
+    {
+      REQUIRE(sqlite3_exec(db_, ddl, nullptr, nullptr, nullptr) == SQLITE_OK);
+    }
+
+    operator sqlite3*() const { return db_; }
+
+  private:
+    sqlite3* db_{nullptr};
+  };
+}
+
+TEST_CASE("Resolve RangeSets")
+{
+  TestDB db;
+  RangeSetResolver resolver{db, "test.db", false};
+
+  auto const& rs1 = resolver.info(InSubRun, 1);
+  CHECK(rs1.run == 3u);
+  CHECK(rs1.ranges ==
+        std::vector<EventRange>{EventRange{1, 1, 4}, EventRange{1, 4, 7}});
+
+  auto const& rs2 = resolver.info(InSubRun, 2);
+  CHECK(rs2.run == 4u);
+  CHECK(rs2.ranges == std::vector<EventRange>{EventRange{2, 10, 12}});
+
+  SECTION("Resolved RangeSets are memoized")
+  {
+    db.exec("DELETE FROM EventRanges;");
+    CHECK(&resolver.info(InSubRun, 1) == &rs1);
+    CHECK(resolver.rangeSet(InSubRun, 2).ranges() == rs2.ranges);
+  }
+
+  SECTION("Invalid RangeSet ID")
+  {
+    auto const invalid_id = std::numeric_limits<unsigned>::max();
+    CHECK(resolver.info(InSubRun, invalid_id).is_invalid());
+    CHECK_FALSE(resolver.rangeSet(InSubRun, invalid_id).is_valid());
+  }
+}
+
+TEST_CASE("Resolve compact RangeSets")
+{
+  TestDB db;
+  RangeSetResolver resolver{db, "test.db", true};
+  auto const& rs1 = resolver.info(InSubRun, 1);
+  CHECK(rs1.run == 3u);
+  CHECK(rs1.ranges == std::vector<EventRange>{EventRange{1, 1, 7}});
+}
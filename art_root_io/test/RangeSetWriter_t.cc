@@ -0,0 +1,127 @@
+#include "art_root_io/detail/RangeSetResolver.h"
+#include "art_root_io/detail/RangeSetWriter.h"
+#include "canvas/Persistency/Provenance/EventRange.h"
+#include "canvas/Persistency/Provenance/RangeSet.h"
+
+#include "sqlite3.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using art::EventRange;
+using art::InRun;
+using art::InSubRun;
+using art::RangeSet;
+using art::detail::RangeSetResolver;
+using art::detail::RangeSetWriter;
+
+namespace {
+  // Same schema as the one created by RootOutputFile.
+  class TestDB {
+  public:
+    TestDB()
+    {
+      sqlite3_open(":memory:", &db_);
+      exec("CREATE TABLE EventRanges(SubRun INTEGER, begin INTEGER, "
+           "end INTEGER, UNIQUE (SubRun,begin,end) ON CONFLICT IGNORE);");
+      for (std::string const bt : {"SubRun", "Run"}) {
+        exec("CREATE TABLE " + bt + "RangeSets(Run INTEGER);");
+        exec("CREATE TABLE " + bt +
+             "RangeSets_EventRanges(RangeSetsID INTEGER, EventRangesID "
+             "INTEGER, PRIMARY KEY(RangeSetsID,EventRangesID)) WITHOUT "
+             "ROWID;");
+      }
+    }
+    ~TestDB() { sqlite3_close(db_); }
+
+    void
+    exec(std::string const& ddl)
+    {
+      REQUIRE(sqlite3_exec(db_, ddl.c_str(), nullptr, nullptr, nullptr) ==
+              SQLITE_OK);
+    }
+
+    int
+    count(std::string const& table)
+    {
+      sqlite3_stmt* stmt{nullptr};
+      auto const ddl = "SELECT count(*) FROM " + table + ';';
+      REQUIRE(sqlite3_prepare_v2(db_, ddl.c_str(), -1, &stmt, nullptr) ==
+              SQLITE_OK);
+      REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+      auto const result = sqlite3_column_int(stmt, 0);
+      sqlite3_finalize(stmt);
+      return result;
+    }
+
+    operator sqlite3*() const { return db_; }
+
+  private:
+    sqlite3* db_{nullptr};
+  };
+}
+
+TEST_CASE("Write RangeSets")
+{
+  TestDB db;
+  RangeSet const rs1{1, {EventRange{1, 1, 4}, EventRange{2, 1, 3}}};
+  RangeSet const rs2{1, {EventRange{2, 1, 3}}};
+  RangeSetWriter writer{db};
+
+  auto const id1 = writer.rangeSetID(InSubRun, rs1);
+  auto const id2 = writer.rangeSetID(InSubRun, rs2);
+  CHECK(id1 != id2);
+  // Equal RangeSets share their ID, per branch type.
+  CHECK(writer.rangeSetID(InSubRun, RangeSet{rs1}) == id1);
+  auto const runID = writer.rangeSetID(InRun, rs2);
+
+  // Nothing is written before the flush.
+  CHECK(db.count("SubRunRangeSets") == 0);
+  writer.flush();
+  CHECK(db.count("SubRunRangeSets") == 2);
+  CHECK(db.count("RunRangeSets") == 1);
+  // EventRanges are shared across RangeSets and branch types.
+  CHECK(db.count("EventRanges") == 2);
+  CHECK(db.count("SubRunRangeSets_EventRanges") == 3);
+  CHECK(db.count("RunRangeSets_EventRanges") == 1);
+
+  RangeSetResolver resolver{db, "test.db", false};
+  CHECK(resolver.rangeSet(InSubRun, id1) == rs1);
+  CHECK(resolver.rangeSet(InSubRun, id2) == rs2);
+  CHECK(resolver.rangeSet(InRun, runID) == rs2);
+
+  SECTION("IDs of RangeSets seen before a flush are kept")
+  {
+    CHECK(writer.rangeSetID(InSubRun, rs2) == id2);
+    writer.flush();
+    CHECK(db.count("SubRunRangeSets") == 2);
+  }
+}
+
+TEST_CASE("Import RangeSets under their own IDs")
+{
+  TestDB db;
+  RangeSet const rs1{1, {EventRange{1, 1, 4}}};
+  RangeSet const rs2{1, {EventRange{2, 1, 3}}};
+  RangeSet const rs3{1, {EventRange{3, 1, 2}}};
+  RangeSetWriter writer{db};
+  REQUIRE(writer.import(InSubRun, {{2u, rs2}, {3u, rs3}}));
+  // New IDs skip the imported ones, and imported RangeSets are reused.
+  CHECK(writer.rangeSetID(InSubRun, rs1) == 1u);
+  CHECK(writer.rangeSetID(InSubRun, rs2) == 2u);
+  CHECK(writer.rangeSetID(InSubRun, RangeSet{1, {EventRange{4, 1, 2}}}) ==
+        4u);
+  // Importing an ID again is allowed only for the same RangeSet.
+  CHECK(writer.import(InSubRun, {{3u, rs3}}));
+  CHECK_FALSE(writer.import(InSubRun, {{5u, rs1}, {1u, rs2}}));
+  writer.flush();
+  CHECK(db.count("SubRunRangeSets") == 4);
+
+  RangeSetResolver resolver{db, "test.db", false};
+  auto const rangeSets = resolver.rangeSets(InSubRun);
+  REQUIRE(rangeSets.size() == 4u);
+  CHECK(rangeSets[1].first == 2u);
+  CHECK(rangeSets[1].second == rs2);
+  CHECK(rangeSets[2].first == 3u);
+  CHECK(rangeSets[2].second == rs3);
+}
@@ -84,6 +84,16 @@ main(int argc, char** argv)
                           rootFile
 #endif
     );
+#ifndef TKEYVFS_NO_ROOT
+  } else if (!strcmp(argv[1], "p")) {
+    // Write the database as keys of 1 KiB pages.
+    rootFile = new TFile(argv[2], "RECREATE");
+    err = tkeyvfs_open_v2(argv[3],
+                          &db,
+                          SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                          rootFile,
+                          1024);
+#endif
   } else {
     fprintf(stderr, "Unrecognized file mode designator %s", argv[1]);
     exit(1);
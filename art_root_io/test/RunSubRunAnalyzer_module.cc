@@ -0,0 +1,99 @@
+// ======================================================================
+// Verifies the values and RangeSets of the products written by
+// RunSubRunProducer.  The RangeSet of the product of a subrun, or run,
+// must cover exactly the events read for it, even when it was written
+// in several fragments, and its value must correspond to the number of
+// those events.
+// ======================================================================
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Provenance.h"
+#include "art/Framework/Principal/Run.h"
+#include "art/Framework/Principal/SubRun.h"
+#include "art/test/TestObjects/ToyProducts.h"
+#include "canvas/Persistency/Provenance/RangeSet.h"
+
+#include <cassert>
+#include <optional>
+
+namespace arttest {
+  class RunSubRunAnalyzer;
+}
+
+class arttest::RunSubRunAnalyzer : public art::EDAnalyzer {
+  art::ProductToken<IntProduct> subRunToken_;
+  art::ProductToken<IntProduct> runToken_;
+
+public:
+  struct Config {
+    fhicl::Atom<std::string> moduleLabel{fhicl::Name{"moduleLabel"}};
+  };
+  using Parameters = Table<Config>;
+
+  explicit RunSubRunAnalyzer(Parameters const& p)
+    : art::EDAnalyzer{p}
+    , subRunToken_{consumes<IntProduct, art::InSubRun>(p().moduleLabel())}
+    , runToken_{consumes<IntProduct, art::InRun>(p().moduleLabel())}
+  {}
+
+  void
+  beginRun(art::Run const&) override
+  {
+    runEvents_ = 0;
+  }
+
+  void
+  beginSubRun(art::SubRun const&) override
+  {
+    subRunEvents_ = 0;
+  }
+
+  void
+  analyze(art::Event const&) override
+  {
+    ++subRunEvents_;
+    ++runEvents_;
+  }
+
+  void
+  endSubRun(art::SubRun const& sr) override
+  {
+    auto const h = sr.getValidHandle(subRunToken_);
+    assert(h->value ==
+           static_cast<int>((100 * sr.run() + sr.subRun()) * subRunEvents_));
+    checkRangeSet(
+      h.provenance()->rangeOfValidity(), sr.run(), sr.subRun(), subRunEvents_);
+  }
+
+  void
+  endRun(art::Run const& r) override
+  {
+    auto const h = r.getValidHandle(runToken_);
+    assert(h->value == static_cast<int>(r.run() * runEvents_));
+    checkRangeSet(
+      h.provenance()->rangeOfValidity(), r.run(), std::nullopt, runEvents_);
+  }
+
+private:
+  static void
+  checkRangeSet(art::RangeSet const& rs,
+                art::RunNumber_t const run,
+                std::optional<art::SubRunNumber_t> const subRun,
+                unsigned const nEvents)
+  {
+    assert(rs.is_valid());
+    assert(rs.run() == run);
+    unsigned covered{};
+    for (auto const& range : rs.ranges()) {
+      assert(!subRun || range.subRun() == *subRun);
+      covered += range.end() - range.begin();
+    }
+    assert(covered == nEvents);
+  }
+
+  unsigned subRunEvents_{};
+  unsigned runEvents_{};
+}; // RunSubRunAnalyzer
+
+DEFINE_ART_MODULE(arttest::RunSubRunAnalyzer)
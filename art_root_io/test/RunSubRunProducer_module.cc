@@ -0,0 +1,67 @@
+// ======================================================================
+// Produces an IntProduct for each subrun and for each run.  Its value
+// is the number of events seen, times a number that identifies the
+// subrun or run, so that the value of a product aggregated over
+// several fragments is known.  See RunSubRunAnalyzer.
+// ======================================================================
+
+#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Principal/Run.h"
+#include "art/Framework/Principal/SubRun.h"
+#include "art/test/TestObjects/ToyProducts.h"
+
+#include <memory>
+
+namespace arttest {
+  class RunSubRunProducer;
+}
+
+class arttest::RunSubRunProducer : public art::EDProducer {
+public:
+  struct Config {};
+  using Parameters = Table<Config>;
+  explicit RunSubRunProducer(Parameters const& ps) : EDProducer{ps}
+  {
+    produces<IntProduct, art::InSubRun>();
+    produces<IntProduct, art::InRun>();
+  }
+
+private:
+  void
+  beginRun(art::Run&) override
+  {
+    runEvents_ = 0;
+  }
+
+  void
+  beginSubRun(art::SubRun&) override
+  {
+    subRunEvents_ = 0;
+  }
+
+  void
+  produce(art::Event&) override
+  {
+    ++subRunEvents_;
+    ++runEvents_;
+  }
+
+  void
+  endSubRun(art::SubRun& sr) override
+  {
+    auto const value = (100 * sr.run() + sr.subRun()) * subRunEvents_;
+    sr.put(std::make_unique<IntProduct>(value), art::subRunFragment());
+  }
+
+  void
+  endRun(art::Run& r) override
+  {
+    r.put(std::make_unique<IntProduct>(r.run() * runEvents_),
+          art::runFragment());
+  }
+
+  unsigned subRunEvents_{};
+  unsigned runEvents_{};
+}; // RunSubRunProducer
+
+DEFINE_ART_MODULE(arttest::RunSubRunProducer)
@@ -0,0 +1,158 @@
+// ======================================================================
+// SeekingRootInput
+//
+// Reads the events listed in 'eventIDs', in that order, by seeking to
+// each of them with RootInput::seekToEvent.  The other parameters are
+// those of RootInput.  The job fails if an event cannot be found, or if
+// another event is read instead.
+// ======================================================================
+
+#include "art/Framework/Core/FileBlock.h"
+#include "art/Framework/Core/InputSource.h"
+#include "art/Framework/Core/InputSourceDescription.h"
+#include "art/Framework/Core/InputSourceMacros.h"
+#include "art/Framework/Principal/EventPrincipal.h"
+#include "art/Framework/Principal/RangeSetHandler.h"
+#include "art/Framework/Principal/RunPrincipal.h"
+#include "art/Framework/Principal/SubRunPrincipal.h"
+#include "art_root_io/RootInput.h"
+#include "canvas/Persistency/Provenance/EventID.h"
+#include "canvas/Utilities/Exception.h"
+#include "fhiclcpp/ParameterSet.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace arttest {
+
+  class SeekingRootInput : public art::InputSource {
+  public:
+    SeekingRootInput(fhicl::ParameterSet const& pset,
+                     art::InputSourceDescription& desc);
+
+    art::input::ItemType nextItemType() override;
+    std::unique_ptr<art::FileBlock> readFile() override;
+    void closeFile() override;
+    std::unique_ptr<art::RunPrincipal> readRun() override;
+    std::unique_ptr<art::SubRunPrincipal> readSubRun(
+      cet::exempt_ptr<art::RunPrincipal const> rp) override;
+    std::unique_ptr<art::EventPrincipal> readEvent(
+      cet::exempt_ptr<art::SubRunPrincipal const> srp) override;
+    std::unique_ptr<art::RangeSetHandler> runRangeSetHandler() override;
+    std::unique_ptr<art::RangeSetHandler> subRunRangeSetHandler() override;
+    void doEndJob() override;
+
+  private:
+    static fhicl::ParameterSet rootInputConfig(fhicl::ParameterSet pset);
+
+    // The transitions are driven through the interface of InputSource,
+    // which RootInput implements privately.
+    art::InputSource&
+    source()
+    {
+      return input_;
+    }
+
+    std::vector<art::EventID> eventIDs_{};
+    std::size_t next_{};
+    bool seekNext_{true};
+    art::RootInput input_;
+  };
+
+}
+
+arttest::SeekingRootInput::SeekingRootInput(fhicl::ParameterSet const& pset,
+                                            art::InputSourceDescription& desc)
+  : InputSource{desc.moduleDescription}
+  , input_{art::RootInput::Parameters{rootInputConfig(pset)}, desc}
+{
+  using triplet_t = std::array<unsigned, 3u>;
+  for (auto const& id : pset.get<std::vector<triplet_t>>("eventIDs")) {
+    eventIDs_.emplace_back(id[0], id[1], id[2]);
+  }
+}
+
+fhicl::ParameterSet
+arttest::SeekingRootInput::rootInputConfig(fhicl::ParameterSet pset)
+{
+  pset.erase("eventIDs");
+  return pset;
+}
+
+art::input::ItemType
+arttest::SeekingRootInput::nextItemType()
+{
+  if (seekNext_) {
+    if (next_ == eventIDs_.size()) {
+      return art::input::IsStop;
+    }
+    if (!input_.seekToEvent(eventIDs_[next_], true)) {
+      throw art::Exception{art::errors::NotFound}
+        << "SeekingRootInput: event " << eventIDs_[next_]
+        << " was not found.\n";
+    }
+    seekNext_ = false;
+  }
+  return source().nextItemType();
+}
+
+std::unique_ptr<art::FileBlock>
+arttest::SeekingRootInput::readFile()
+{
+  return source().readFile();
+}
+
+void
+arttest::SeekingRootInput::closeFile()
+{
+  source().closeFile();
+}
+
+std::unique_ptr<art::RunPrincipal>
+arttest::SeekingRootInput::readRun()
+{
+  return source().readRun();
+}
+
+std::unique_ptr<art::SubRunPrincipal>
+arttest::SeekingRootInput::readSubRun(
+  cet::exempt_ptr<art::RunPrincipal const> rp)
+{
+  return source().readSubRun(rp);
+}
+
+std::unique_ptr<art::EventPrincipal>
+arttest::SeekingRootInput::readEvent(
+  cet::exempt_ptr<art::SubRunPrincipal const> srp)
+{
+  auto result = source().readEvent(srp);
+  if (result->eventID() != eventIDs_[next_]) {
+    throw art::Exception{art::errors::LogicError}
+      << "SeekingRootInput: event " << result->eventID()
+      << " was read instead of event " << eventIDs_[next_] << ".\n";
+  }
+  ++next_;
+  seekNext_ = true;
+  return result;
+}
+
+std::unique_ptr<art::RangeSetHandler>
+arttest::SeekingRootInput::runRangeSetHandler()
+{
+  return source().runRangeSetHandler();
+}
+
+std::unique_ptr<art::RangeSetHandler>
+arttest::SeekingRootInput::subRunRangeSetHandler()
+{
+  return source().subRunRangeSetHandler();
+}
+
+void
+arttest::SeekingRootInput::doEndJob()
+{
+  source().doEndJob();
+}
+
+DEFINE_ART_INPUT_SOURCE(arttest::SeekingRootInput)
@@ -0,0 +1,31 @@
+#!/bin/bash
+# Reports RootInput read throughput (events/s) and the output file size
+# for a file written with ROOT's default basket and cluster sizes, and
+# for one written with RootOutput's layout optimization
+# (basketOptimizationEvents).
+#
+# Usage: basket_layout_benchmark.sh [<basketOptimizationEvents>]
+
+window=${1:-100}
+nevents=2000 # As configured in io_benchmark_w.fcl
+
+printf "%-10s %-12s %s\n" layout size[MB] events/s
+for layout in default optimized; do
+  { cat io_benchmark_w.fcl
+    echo "outputs.o1.fileName: \"io_benchmark_${layout}.root\""
+    if [ ${layout} = optimized ]; then
+      echo "outputs.o1.basketOptimizationEvents: ${window}"
+    fi; } > io_benchmark_w_${layout}.fcl
+  { cat io_benchmark_r.fcl
+    echo "source.fileNames: [\"io_benchmark_${layout}.root\"]"; } \
+    > io_benchmark_r_${layout}.fcl
+  art --rethrow-all -c io_benchmark_w_${layout}.fcl \
+    >& io_benchmark_w_${layout}.log || exit 1
+  start=$(date +%s.%N)
+  art --rethrow-all -c io_benchmark_r_${layout}.fcl \
+    >& io_benchmark_r_${layout}.log || exit 1
+  end=$(date +%s.%N)
+  size=$(stat -c %s io_benchmark_${layout}.root)
+  awk -v l=${layout} -v z=${size} -v s=${start} -v e=${end} -v ev=${nevents} \
+    'BEGIN { printf "%-10s %-12.1f %.1f\n", l, z / 1.e6, ev / (e - s) }'
+done
@@ -0,0 +1,81 @@
+// Checks the layout of the Events tree of a file written by RootOutput
+// with 'basketOptimizationEvents': the cluster size recorded in the
+// tree, and that the basket sizes were chosen within the memory budget
+// instead of being left at their default.
+//
+// Usage: check_basket_layout <file> <clusterSize> <basketMemoryBudget>
+//          <defaultBasketSize>
+
+#include "TBranch.h"
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TObjArray.h"
+#include "TTree.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <set>
+
+int
+main(int argc, char** argv)
+{
+  if (argc != 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " <file> <clusterSize> <basketMemoryBudget>"
+                 " <defaultBasketSize>\n";
+    return 1;
+  }
+  Long64_t const clusterSize{std::atoll(argv[2])};
+  Long64_t const budget{std::atoll(argv[3])};
+  Int_t const defaultBasketSize{std::atoi(argv[4])};
+
+  std::unique_ptr<TFile> file{TFile::Open(argv[1])};
+  if (!file || file->IsZombie()) {
+    std::cerr << "Unable to open " << argv[1] << ".\n";
+    return 1;
+  }
+  TTree* tree{nullptr};
+  file->GetObject("Events", tree);
+  if (tree == nullptr) {
+    std::cerr << "No Events tree in " << argv[1] << ".\n";
+    return 1;
+  }
+
+  int nErrors{};
+  if (tree->GetAutoFlush() != clusterSize) {
+    std::cerr << "The auto-flush of the tree is " << tree->GetAutoFlush()
+              << " instead of " << clusterSize << ".\n";
+    ++nErrors;
+  }
+
+  // TTree::OptimizeBaskets resizes the baskets of the branches that
+  // hold the leaves of the tree.
+  Long64_t totalBasketSize{};
+  TBranch* largest{nullptr};
+  std::set<TBranch*> branches;
+  for (auto* obj : *tree->GetListOfLeaves()) {
+    auto* branch = static_cast<TLeaf*>(obj)->GetBranch();
+    if (!branches.insert(branch).second) {
+      continue;
+    }
+    totalBasketSize += branch->GetBasketSize();
+    if (largest == nullptr || branch->GetTotBytes() > largest->GetTotBytes()) {
+      largest = branch;
+    }
+  }
+  if (largest == nullptr || largest->GetBasketSize() == defaultBasketSize) {
+    std::cerr << "The basket sizes were not optimized.\n";
+    ++nErrors;
+  }
+  // TTree::OptimizeBaskets may exceed the budget by rounding.
+  if (totalBasketSize > budget * 11 / 10) {
+    std::cerr << "The baskets of the tree take " << totalBasketSize
+              << " bytes, more than the budget of " << budget << ".\n";
+    ++nErrors;
+  }
+  if (nErrors != 0) {
+    return 1;
+  }
+  std::cout << "The layout of the Events tree is optimized.\n";
+}
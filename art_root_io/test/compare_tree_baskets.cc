@@ -0,0 +1,139 @@
+// Compares the Events and EventMetaData trees of two art/ROOT files,
+// basket by basket.  The trees must have the same branches, with the
+// same entries, basket boundaries, compressed sizes and uncompressed
+// basket contents.  Where the baskets are placed in the files is not
+// compared.
+//
+// Usage: compare_tree_baskets <file1> <file2>
+
+#include "TBasket.h"
+#include "TBranch.h"
+#include "TBuffer.h"
+#include "TFile.h"
+#include "TObjArray.h"
+#include "TTree.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+  int nDifferences{};
+
+  void
+  difference(std::string const& branchName, std::string const& what)
+  {
+    std::cerr << "Branch " << branchName << ": " << what << '\n';
+    ++nDifferences;
+  }
+
+  void compareBranchLists(TObjArray& a, TObjArray& b);
+
+  void
+  compareBranches(TBranch& a, TBranch& b)
+  {
+    std::string const name{a.GetName()};
+    if (name != b.GetName()) {
+      difference(name, std::string{"differs from "} + b.GetName() + '.');
+      return;
+    }
+    if (a.GetEntries() != b.GetEntries()) {
+      difference(name, "the numbers of entries differ.");
+      return;
+    }
+    if (a.GetWriteBasket() != b.GetWriteBasket()) {
+      difference(name, "the numbers of baskets differ.");
+      return;
+    }
+    if (a.GetTotBytes() != b.GetTotBytes() ||
+        a.GetZipBytes() != b.GetZipBytes()) {
+      difference(name, "the sizes differ.");
+    }
+    for (Int_t i = 0; i != a.GetWriteBasket(); ++i) {
+      auto const basket = std::to_string(i);
+      if (a.GetBasketEntry()[i] != b.GetBasketEntry()[i]) {
+        difference(name, "basket " + basket + " starts at another entry.");
+        continue;
+      }
+      auto* basketA = a.GetBasket(i);
+      auto* basketB = b.GetBasket(i);
+      if (basketA == nullptr || basketB == nullptr) {
+        difference(name, "basket " + basket + " cannot be read.");
+        continue;
+      }
+      // The key at the start of the buffer holds the location of the
+      // basket in its file.
+      auto const keylen = basketA->GetKeylen();
+      auto const last = basketA->GetLast();
+      if (keylen != basketB->GetKeylen() || last != basketB->GetLast() ||
+          std::memcmp(basketA->GetBufferRef()->Buffer() + keylen,
+                      basketB->GetBufferRef()->Buffer() + keylen,
+                      last - keylen) != 0) {
+        difference(name, "the contents of basket " + basket + " differ.");
+      }
+    }
+    compareBranchLists(*a.GetListOfBranches(), *b.GetListOfBranches());
+  }
+
+  void
+  compareBranchLists(TObjArray& a, TObjArray& b)
+  {
+    if (a.GetEntriesFast() != b.GetEntriesFast()) {
+      ++nDifferences;
+      std::cerr << "The numbers of branches differ.\n";
+      return;
+    }
+    for (Int_t i = 0; i != a.GetEntriesFast(); ++i) {
+      compareBranches(*static_cast<TBranch*>(a.UncheckedAt(i)),
+                      *static_cast<TBranch*>(b.UncheckedAt(i)));
+    }
+  }
+
+  TTree*
+  getTree(TFile& file, char const* name)
+  {
+    TTree* tree{nullptr};
+    file.GetObject(name, tree);
+    if (tree == nullptr) {
+      ++nDifferences;
+      std::cerr << "File " << file.GetName() << " has no tree " << name
+                << ".\n";
+    }
+    return tree;
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <file1> <file2>\n";
+    return 1;
+  }
+  std::unique_ptr<TFile> fileA{TFile::Open(argv[1])};
+  std::unique_ptr<TFile> fileB{TFile::Open(argv[2])};
+  if (!fileA || fileA->IsZombie() || !fileB || fileB->IsZombie()) {
+    std::cerr << "Unable to open the files to compare.\n";
+    return 1;
+  }
+  for (auto const* name : {"Events", "EventMetaData"}) {
+    auto* treeA = getTree(*fileA, name);
+    auto* treeB = getTree(*fileB, name);
+    if (treeA == nullptr || treeB == nullptr) {
+      continue;
+    }
+    if (treeA->GetEntries() != treeB->GetEntries()) {
+      ++nDifferences;
+      std::cerr << "The numbers of entries of tree " << name << " differ.\n";
+      continue;
+    }
+    compareBranchLists(*treeA->GetListOfBranches(),
+                       *treeB->GetListOfBranches());
+  }
+  if (nDifferences != 0) {
+    std::cerr << nDifferences << " difference(s) found.\n";
+    return 1;
+  }
+  std::cout << "The trees are identical.\n";
+}
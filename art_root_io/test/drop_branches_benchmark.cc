@@ -0,0 +1,140 @@
+// Compares the time to open a wide file and drop all but a few of the
+// branches of its tree, as done by RootInput for 'inputCommands' such
+// as [ "drop *", "keep X" ], when the branches are removed one at a
+// time (the former detail::dropBranch, copied below) with the time when
+// they are removed in a single pass (detail::dropBranches).
+//
+// The file is opened once before the measurements, and the two methods
+// are then timed alternately, starting with each in turn; the fastest
+// time of each is reported.
+//
+// Usage: drop_branches_benchmark [<nBranches> [<nKept> [<nRounds>]]]
+
+#include "art_root_io/detail/dropBranch.h"
+
+#include "TBranch.h"
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TObjArray.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+  std::string const fileName{"drop_branches_benchmark.root"};
+
+  std::string
+  branchName(int const i)
+  {
+    return "ints_producer" + std::to_string(i) + "__PROC.";
+  }
+
+  void
+  writeFile(int const nBranches)
+  {
+    TFile file{fileName.c_str(), "RECREATE"};
+    auto tree = new TTree{"Events", ""};
+    std::vector<int> values(nBranches);
+    for (int i = 0; i != nBranches; ++i) {
+      tree->Branch(branchName(i).c_str(), &values[i], "value/I");
+    }
+    for (int entry = 0; entry != 10; ++entry) {
+      tree->Fill();
+    }
+    tree->Write();
+  }
+
+  // The implementation of detail::dropBranch before dropBranches was
+  // introduced: the lists of leaves and branches are scanned and
+  // compacted for each branch.
+  void
+  formerDropBranch(TTree* tree, std::string const& branchName)
+  {
+    TBranch* branch = tree->GetBranch(branchName.c_str());
+    if (!branch) {
+      return;
+    }
+    TObjArray* leaves = tree->GetListOfLeaves();
+    int entries = leaves->GetEntries();
+    for (int i = 0; i < entries; ++i) {
+      auto leaf = reinterpret_cast<TLeaf*>((*leaves)[i]);
+      if (leaf == nullptr) {
+        continue;
+      }
+      TBranch* br = leaf->GetBranch();
+      if (br == nullptr) {
+        continue;
+      }
+      if (br->GetMother() == branch) {
+        leaves->Remove(leaf);
+      }
+    }
+    leaves->Compress();
+    tree->GetListOfBranches()->Remove(branch);
+    tree->GetListOfBranches()->Compress();
+    delete branch;
+  }
+
+  template <typename F>
+  double
+  msToOpenAndDrop(std::vector<std::string> const& dropped, F drop)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    std::unique_ptr<TFile> file{TFile::Open(fileName.c_str())};
+    auto tree = file->Get<TTree>("Events");
+    drop(tree, dropped);
+    std::chrono::duration<double, std::milli> const elapsed{
+      std::chrono::steady_clock::now() - start};
+    return elapsed.count();
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  int const nBranches = argc > 1 ? std::atoi(argv[1]) : 5000;
+  int const nKept = argc > 2 ? std::atoi(argv[2]) : 5;
+  int const nRounds = argc > 3 ? std::atoi(argv[3]) : 3;
+
+  writeFile(nBranches);
+  std::vector<std::string> dropped;
+  for (int i = nKept; i < nBranches; ++i) {
+    dropped.push_back(branchName(i));
+  }
+
+  auto oneByOne = [](auto tree, auto& names) {
+    for (auto const& name : names) {
+      formerDropBranch(tree, name);
+    }
+  };
+  auto bulk = [](auto tree, auto& names) {
+    art::detail::dropBranches(tree, names);
+  };
+
+  // Warm up: the file is in the page cache and ROOT has loaded what it
+  // needs before anything is timed.
+  msToOpenAndDrop({}, bulk);
+
+  double oneByOneMs{std::numeric_limits<double>::max()};
+  double bulkMs{std::numeric_limits<double>::max()};
+  for (int round = 0; round != 2 * nRounds; ++round) {
+    if (round % 2 == 0) {
+      oneByOneMs = std::min(oneByOneMs, msToOpenAndDrop(dropped, oneByOne));
+      bulkMs = std::min(bulkMs, msToOpenAndDrop(dropped, bulk));
+    } else {
+      bulkMs = std::min(bulkMs, msToOpenAndDrop(dropped, bulk));
+      oneByOneMs = std::min(oneByOneMs, msToOpenAndDrop(dropped, oneByOne));
+    }
+  }
+
+  std::printf("%-28s %10s\n", "Branch removal", "ms");
+  std::printf("%-28s %10.1f\n", "One branch at a time", oneByOneMs);
+  std::printf("%-28s %10.1f\n", "Single pass", bulkMs);
+}
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Reports RootOutput write throughput (events/s) as a function of the
+# number of threads, with sequential and with parallel basket
+# compression.
+#
+# Usage: io_write_scaling_benchmark.sh [<nthreads>...]
+
+threads=(${@:-1 2 4 8})
+
+nevents=2000 # As configured in io_benchmark_w.fcl
+
+printf "%-8s %-26s %s\n" threads parallelBasketCompression events/s
+for parallel in false true; do
+  { cat io_benchmark_w.fcl;
+    echo "outputs.o1.parallelBasketCompression: ${parallel}"; } \
+    > io_benchmark_w_${parallel}.fcl
+  for n in "${threads[@]}"; do
+    start=$(date +%s.%N)
+    art --rethrow-all -c io_benchmark_w_${parallel}.fcl -j ${n} \
+      -o io_benchmark_${parallel}_${n}.root \
+      >& io_benchmark_w_${parallel}_${n}.log || exit 1
+    end=$(date +%s.%N)
+    awk -v n=${n} -v p=${parallel} -v s=${start} -v e=${end} -v ev=${nevents} \
+      'BEGIN { printf "%-8d %-26s %.1f\n", n, p, ev / (e - s) }'
+  done
+done
@@ -0,0 +1,88 @@
+// Compares the per-product read latency of a delayed read that looks
+// up the dictionary of the wrapped product type on every read (the
+// former RootDelayedReader behavior) with one that allocates the
+// product through input::BranchInfo::newProduct, as RootDelayedReader
+// now does.
+//
+// Usage: product_read_latency_benchmark [<nEntries> [<productSize>]]
+
+#include "art_root_io/Inputfwd.h"
+#include "canvas/Persistency/Common/EDProduct.h"
+#include "canvas/Persistency/Common/Wrapper.h"
+#include "canvas/Persistency/Provenance/BranchDescription.h"
+#include "canvas/Persistency/Provenance/BranchType.h"
+#include "canvas/Persistency/Provenance/ProcessConfiguration.h"
+#include "canvas/Persistency/Provenance/TypeLabel.h"
+#include "canvas/Utilities/TypeID.h"
+#include "fhiclcpp/ParameterSetID.h"
+
+#include "TBranch.h"
+#include "TClass.h"
+#include "TTree.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+  using product_t = std::vector<double>;
+
+  template <typename F>
+  double
+  nsPerRead(TBranch* branch, long const nEntries, F newProduct)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    for (long i = 0; i != nEntries; ++i) {
+      std::unique_ptr<art::EDProduct> p{newProduct()};
+      auto pp = p.get();
+      branch->SetAddress(&pp);
+      branch->GetEntry(i);
+    }
+    std::chrono::duration<double, std::nano> const elapsed{
+      std::chrono::steady_clock::now() - start};
+    return elapsed.count() / nEntries;
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  long const nEntries = argc > 1 ? std::atol(argv[1]) : 100000;
+  std::size_t const productSize = argc > 2 ? std::atol(argv[2]) : 10;
+
+  art::BranchDescription const description{
+    art::InEvent,
+    art::TypeLabel{art::TypeID{typeid(product_t)}, {}, false, "producer"},
+    "producer",
+    fhicl::ParameterSetID{},
+    art::ProcessConfiguration{"PROC", fhicl::ParameterSetID{}, "v1"}};
+  auto const& wrappedName = description.wrappedName();
+
+  // In-memory tree, so that the measurement is not dominated by I/O.
+  TTree tree{"Events", ""};
+  tree.SetDirectory(nullptr);
+  auto product = new art::Wrapper<product_t>{
+    std::make_unique<product_t>(productSize, 1.)};
+  auto branch = tree.Branch(
+    description.branchName().c_str(), wrappedName.c_str(), &product);
+  for (long i = 0; i != nEntries; ++i) {
+    tree.Fill();
+  }
+  delete product;
+
+  auto const lookup = nsPerRead(branch, nEntries, [&wrappedName] {
+    TClass* cl = TClass::GetClass(wrappedName.c_str());
+    return static_cast<art::EDProduct*>(cl->New());
+  });
+
+  art::input::BranchInfo const info{description, branch};
+  auto const cached =
+    nsPerRead(branch, nEntries, [&info] { return info.newProduct(); });
+
+  std::printf("%-28s %10s\n", "Allocation", "ns/read");
+  std::printf("%-28s %10.1f\n", "TClass lookup per read", lookup);
+  std::printf("%-28s %10.1f\n", "BranchInfo::newProduct", cached);
+}